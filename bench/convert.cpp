@@ -0,0 +1,75 @@
+// CPU time of the cvtColor(BGR2RGB) + flip() passes frames used to go
+// through before upload, now left to texture swizzle and coordinates. The
+// decode side is timed on the video's own frames, the writer side on
+// frames of the output resolution.
+//
+// Usage: bench-convert <video path> [frames] [output height]
+
+// STL
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "decode/Backend.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+double convertMS(const cv::Mat& frame) {
+    cv::Mat mat = frame.clone();
+
+    auto start = Clock::now();
+    cv::cvtColor(mat, mat, cv::COLOR_BGR2RGB);
+    cv::flip(mat, mat, 0);
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+    return elapsed.count();
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <video path> [frames] [output height]" << std::endl;
+        return 1;
+    }
+
+    std::string path = argv[1];
+    int max_frames = argc > 2 ? std::stoi(argv[2]) : 300;
+    int out_height = argc > 3 ? std::stoi(argv[3]) : 1080;
+
+    auto backend = vidrevolt::decode::Backend::create(vidrevolt::decode::Backend::OpenCV, path);
+
+    vidrevolt::decode::Frame frame;
+    int frames = 0;
+    double decode_ms = 0;
+    double writer_ms = 0;
+    cv::Size out_size;
+    while (frames < max_frames && backend->read(frame)) {
+        decode_ms += convertMS(frame.mat);
+
+        if (out_size.area() == 0) {
+            out_size = cv::Size(frame.mat.cols * out_height / frame.mat.rows, out_height);
+        }
+
+        cv::Mat out;
+        cv::resize(frame.mat, out, out_size);
+        writer_ms += convertMS(out);
+
+        frames++;
+    }
+
+    if (frames == 0) {
+        std::cerr << "No frames read from " << path << std::endl;
+        return 1;
+    }
+
+    std::cout << path << ": " << frames << " frames" << std::endl;
+    std::cout << "  decode thread: " << decode_ms / frames << "ms/frame saved at " <<
+        frame.mat.cols << "x" << frame.mat.rows << std::endl;
+    std::cout << "  writer thread: " << writer_ms / frames << "ms/frame saved at " <<
+        out_size.width << "x" << out_size.height << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Decode throughput of each backend on the same files: sequential reads,
+// then random seeks.
+//
+// Usage: bench-decode <video path>...
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Ours
+#include "decode/Backend.h"
+
+#define SEEKS 50
+
+using Clock = std::chrono::high_resolution_clock;
+
+void bench(vidrevolt::decode::Backend::Type type, const std::string& name, const std::string& path) {
+    auto backend = vidrevolt::decode::Backend::create(type, path);
+    auto md = backend->probe();
+
+    auto start = Clock::now();
+    vidrevolt::decode::Frame frame;
+    int frames = 0;
+    while (backend->read(frame)) {
+        frames++;
+    }
+    std::chrono::duration<double> read_s = Clock::now() - start;
+
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> dist(0, std::max(0, md.frame_count - 1));
+    start = Clock::now();
+    int misses = 0;
+    for (int i = 0; i < SEEKS; i++) {
+        int pos = dist(gen);
+        backend->seek(pos);
+        if (!backend->read(frame) || frame.pos != pos) {
+            misses++;
+        }
+    }
+    std::chrono::duration<double, std::milli> seek_ms = Clock::now() - start;
+
+    std::cout << "  " << name << ": " << frames << " frames at " << frames / read_s.count() << "fps, " <<
+        "seek+read " << seek_ms.count() / SEEKS << "ms, " << misses << "/" << SEEKS << " inexact seeks" << std::endl;
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <video path>..." << std::endl;
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::cout << argv[i] << std::endl;
+        bench(vidrevolt::decode::Backend::OpenCV, "opencv", argv[i]);
+        bench(vidrevolt::decode::Backend::LibAV, "libav ", argv[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Fills the compressed frame cache from a video, then reads it back at
+// random and in reverse, reporting hit rate and compress/decompress
+// throughput next to the decoder's own.
+//
+// Usage: bench-frame-cache <video path> [frames] [cache MB]
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Ours
+#include "FrameCache.h"
+#include "decode/Backend.h"
+
+#define LOOKUPS 1000
+
+using Clock = std::chrono::high_resolution_clock;
+
+int main(int argc, const char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <video path> [frames] [cache MB]" << std::endl;
+        return 1;
+    }
+
+    std::string path = argv[1];
+    int max_frames = argc > 2 ? std::stoi(argv[2]) : 300;
+    size_t limit_mb = argc > 3 ? static_cast<size_t>(std::stoul(argv[3])) : 1024;
+
+    auto& cache = vidrevolt::FrameCache::getInstance();
+    cache.setLimit(limit_mb * 1024 * 1024);
+
+    auto backend = vidrevolt::decode::Backend::create(vidrevolt::decode::Backend::OpenCV, path);
+
+    // Decode and cache
+    vidrevolt::decode::Frame frame;
+    double decode_ms = 0;
+    double frame_mb = 0;
+    int frames = 0;
+    while (frames < max_frames) {
+        auto start = Clock::now();
+        if (!backend->read(frame)) {
+            break;
+        }
+        decode_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        cache.put(path, frame);
+        frame_mb = static_cast<double>(frame.mat.total() * frame.mat.elemSize()) / (1024 * 1024);
+        frames++;
+    }
+
+    if (frames == 0) {
+        std::cerr << "No frames decoded from " << path << std::endl;
+        return 1;
+    }
+
+    auto filled = cache.getStats();
+    std::cout << frames << " frames decoded at " << decode_ms / frames << "ms each, cached " << filled.frames <<
+        " (" << filled.bytes / (1024 * 1024) << "MB, ratio " <<
+        static_cast<double>(filled.raw_bytes) / static_cast<double>(std::max<size_t>(filled.bytes, 1)) << ")" << std::endl;
+    std::cout << "compress: " << filled.compress_ms / frames << "ms/frame, " <<
+        frame_mb * frames / (filled.compress_ms / 1000) << "MB/s" << std::endl;
+
+    // Random access, then a reverse pass
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> dist(0, frames - 1);
+    for (const char* name : {"random", "reverse"}) {
+        auto before = cache.getStats();
+
+        int lookups = std::string(name) == "random" ? LOOKUPS : frames;
+        for (int i = 0; i < lookups; i++) {
+            int pos = std::string(name) == "random" ? dist(gen) : frames - 1 - i;
+            cache.get(path, pos);
+        }
+
+        auto after = cache.getStats();
+        size_t hits = after.hits - before.hits;
+        double ms = after.decompress_ms - before.decompress_ms;
+        std::cout << name << ": hit rate " << static_cast<double>(hits) / lookups * 100 << "%, decompress " <<
+            (hits > 0 ? ms / static_cast<double>(hits) : 0) << "ms/frame, " <<
+            (ms > 0 ? frame_mb * static_cast<double>(hits) / (ms / 1000) : 0) << "MB/s" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Compares the refill and nextFrame() lock hold times of the old vector
+// shifting buffer against FrameRing, using synthetic 1080p frames.
+
+// STL
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "FrameRing.h"
+
+#define BUFFER_SIZE 30
+#define MIDDLE 15
+#define ITERATIONS 2000
+
+using Frame = vidrevolt::FrameRing::Frame;
+using Clock = std::chrono::high_resolution_clock;
+
+struct Timing {
+    double refill_ms = 0;
+    double lock_ms = 0;
+};
+
+double elapsedMS(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::vector<Frame> makeFrames(int first, int count, const cv::Mat& proto) {
+    std::vector<Frame> frames;
+    for (int i = 0; i < count; i++) {
+        frames.push_back(Frame{first + i, 0, proto.clone()});
+    }
+
+    return frames;
+}
+
+Timing benchVector(const cv::Mat& proto, int diff) {
+    std::mutex mutex;
+    std::vector<Frame> buffer = makeFrames(0, BUFFER_SIZE, proto);
+    int cursor = MIDDLE;
+
+    Timing timing;
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::vector<Frame> tmp_buf = makeFrames(buffer.back().pos + 1, diff, proto);
+
+        auto start = Clock::now();
+        {
+            std::lock_guard guard(mutex);
+            buffer.insert(buffer.end(), tmp_buf.begin(), tmp_buf.end());
+            buffer.erase(buffer.begin(), buffer.begin() + diff);
+        }
+        timing.refill_ms += elapsedMS(start);
+
+        start = Clock::now();
+        {
+            std::lock_guard guard(mutex);
+            cv::Mat frame = buffer.at(static_cast<size_t>(cursor)).mat;
+        }
+        timing.lock_ms += elapsedMS(start);
+    }
+
+    return timing;
+}
+
+Timing benchRing(const cv::Mat& proto, int diff) {
+    std::mutex mutex;
+    vidrevolt::FrameRing buffer(BUFFER_SIZE);
+    for (auto& frame : makeFrames(0, BUFFER_SIZE, proto)) {
+        buffer.pushBack(frame);
+    }
+    int cursor = MIDDLE;
+
+    Timing timing;
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::vector<Frame> tmp_buf = makeFrames(buffer.back().pos + 1, diff, proto);
+
+        auto start = Clock::now();
+        {
+            std::lock_guard guard(mutex);
+            for (auto& frame : tmp_buf) {
+                buffer.pushBack(frame);
+            }
+        }
+        timing.refill_ms += elapsedMS(start);
+
+        start = Clock::now();
+        {
+            std::lock_guard guard(mutex);
+            cv::Mat frame = buffer.at(static_cast<size_t>(cursor)).mat;
+        }
+        timing.lock_ms += elapsedMS(start);
+    }
+
+    return timing;
+}
+
+int main() {
+    cv::Mat proto(1080, 1920, CV_8UC3);
+
+    for (int diff : {1, 4, 15}) {
+        Timing vec = benchVector(proto, diff);
+        Timing ring = benchRing(proto, diff);
+
+        std::cout << "refill of " << diff << " frame(s)" << std::endl;
+        std::cout << "  vector: refill " << vec.refill_ms / ITERATIONS << "ms, "
+            << "nextFrame lock " << vec.lock_ms / ITERATIONS << "ms" << std::endl;
+        std::cout << "  ring:   refill " << ring.refill_ms / ITERATIONS << "ms, "
+            << "nextFrame lock " << ring.lock_ms / ITERATIONS << "ms" << std::endl;
+    }
+
+    return 0;
+}
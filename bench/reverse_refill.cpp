@@ -0,0 +1,57 @@
+// Plays a video in reverse for a while, with and without the keyframe
+// index, and reports how long refills took.
+//
+// Usage: bench-reverse-refill <video path> [frames]
+
+// STL
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Ours
+#include "Video.h"
+
+vidrevolt::Video::Stats playReverse(const std::string& path, bool index, int frames) {
+    vidrevolt::Video::Options opts;
+    opts.keyframe_index = index;
+
+    vidrevolt::Video vid(path, false, vidrevolt::Video::Reverse, opts);
+    vid.start();
+    vid.waitForLoaded();
+    vid.inFocus();
+
+    if (index) {
+        while (!vid.getStats().keyframes_indexed) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    auto frame_dur = std::chrono::duration<double>(1 / vid.getFPS());
+    for (int i = 0; i < frames; i++) {
+        vid.nextFrame(true);
+        std::this_thread::sleep_for(frame_dur);
+    }
+
+    return vid.getStats();
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <video path> [frames]" << std::endl;
+        return 1;
+    }
+
+    std::string path = argv[1];
+    int frames = argc > 2 ? std::stoi(argv[2]) : 300;
+
+    for (bool index : {false, true}) {
+        auto stats = playReverse(path, index, frames);
+        std::cout << (index ? "with index:    " : "without index: ") <<
+            "refill avg " << stats.refill_avg_ms << "ms, max " << stats.refill_max_ms << "ms, " <<
+            stats.refills << " refills, " << stats.underruns << " underruns, " <<
+            stats.frames_decoded << " frames decoded, " << stats.frames_reused << " reused" << std::endl;
+    }
+
+    return 0;
+}
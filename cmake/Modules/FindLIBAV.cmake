@@ -9,6 +9,7 @@
 #  LIBAVCODEC_INCLUDE_DIR  - libavcodec include directory
 #  LIBAVFORMAT_LIBRARY     - libavformat library
 #  LIBAVUTIL_LIBRARY       - libavutil library
+#  LIBSWSCALE_LIBRARY      - libswscale library
 #
 #  Copyright (c) 2008 Andreas Schneider <mail@cynapses.org>
 #  Modified for other libraries by Lasse Kärkkäinen <tronic>
@@ -35,6 +36,9 @@ if(PKG_CONFIG_FOUND)
     if(NOT LIBAVUTIL_LIBRARY)
         pkg_check_modules(_LIBAV_AVUTIL libavutil)
     endif()
+    if(NOT LIBSWSCALE_LIBRARY)
+        pkg_check_modules(_LIBAV_SWSCALE libswscale)
+    endif()
 endif(PKG_CONFIG_FOUND)
 
 find_path(LIBAVCODEC_INCLUDE_DIR
@@ -68,10 +72,18 @@ find_library(LIBAVUTIL_LIBRARY
           /opt/local/lib /sw/lib            #macports & fink
 )
 
+find_library(LIBSWSCALE_LIBRARY
+    NAMES swscale
+    PATHS ${_LIBAV_SWSCALE_LIBRARY_DIRS}    #pkg-config
+          /usr/lib /usr/local/lib           #system level
+          /opt/local/lib /sw/lib            #macports & fink
+)
+
 find_package_handle_standard_args(LIBAV DEFAULT_MSG LIBAVCODEC_LIBRARY
                                                     LIBAVCODEC_INCLUDE_DIR
                                                     LIBAVFORMAT_LIBRARY
                                                     LIBAVUTIL_LIBRARY
+                                                    LIBSWSCALE_LIBRARY
                                                     )
 set(LIBAV_INCLUDE_DIR ${LIBAVCODEC_INCLUDE_DIR}
                       #TODO: add other include paths
@@ -79,6 +91,7 @@ set(LIBAV_INCLUDE_DIR ${LIBAVCODEC_INCLUDE_DIR}
 set(LIBAV_LIBRARIES ${LIBAVCODEC_LIBRARY}
                     ${LIBAVFORMAT_LIBRARY}
                     ${LIBAVUTIL_LIBRARY}
+                    ${LIBSWSCALE_LIBRARY}
                     )
 
 mark_as_advanced(LIBAV_INCLUDE_DIR
@@ -86,5 +99,6 @@ mark_as_advanced(LIBAV_INCLUDE_DIR
                  LIBAVCODEC_LIBRARY
                  LIBAVCODEC_INCLUDE_DIR
                  LIBAVFORMAT_LIBRARY
-                 LIBAVUTIL_LIBRARY)
+                 LIBAVUTIL_LIBRARY
+                 LIBSWSCALE_LIBRARY)
 
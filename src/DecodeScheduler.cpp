@@ -0,0 +1,146 @@
+#include "DecodeScheduler.h"
+
+// STL
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace vidrevolt {
+    DecodeScheduler::Job::WaitStats DecodeScheduler::Job::getQueueWait() const {
+        std::lock_guard guard(wait_mutex_);
+        return wait_;
+    }
+
+    void DecodeScheduler::Job::recordQueueWait(double ms) {
+        std::lock_guard guard(wait_mutex_);
+
+        wait_.count++;
+        wait_.last_ms = ms;
+        wait_.max_ms = std::max(wait_.max_ms, ms);
+        wait_.avg_ms += (ms - wait_.avg_ms) / static_cast<double>(wait_.count);
+    }
+
+    DecodeScheduler& DecodeScheduler::getInstance() {
+        static DecodeScheduler scheduler(std::max(1u, std::thread::hardware_concurrency()));
+        return scheduler;
+    }
+
+    DecodeScheduler::DecodeScheduler(size_t workers) {
+        for (size_t i = 0; i < workers; i++) {
+            workers_.emplace_back(&DecodeScheduler::loop, this);
+        }
+    }
+
+    DecodeScheduler::~DecodeScheduler() {
+        {
+            std::lock_guard guard(mutex_);
+            stopping_ = true;
+        }
+
+        work_cv_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t DecodeScheduler::getWorkerCount() const {
+        return workers_.size();
+    }
+
+    void DecodeScheduler::schedule(Job* job) {
+        {
+            std::lock_guard guard(mutex_);
+
+            if (running_.count(job)) {
+                requeue_.emplace(job, Clock::now());
+                return;
+            }
+
+            if (!queued_.emplace(job, Clock::now()).second) {
+                return;
+            }
+        }
+
+        work_cv_.notify_one();
+    }
+
+    void DecodeScheduler::cancel(Job* job) {
+        std::unique_lock lk(mutex_);
+
+        queued_.erase(job);
+        requeue_.erase(job);
+        done_cv_.wait(lk, [this, job]{ return running_.count(job) == 0; });
+
+        // It may have been rescheduled while we waited
+        queued_.erase(job);
+        requeue_.erase(job);
+    }
+
+    DecodeScheduler::Job* DecodeScheduler::pop() {
+        // Earliest deadline first, ties go to whoever has waited longest.
+        auto best = queued_.end();
+        double best_deadline = std::numeric_limits<double>::infinity();
+        for (auto it = queued_.begin(); it != queued_.end(); it++) {
+            double deadline = it->first->getDeadlineMS();
+            if (best == queued_.end() || deadline < best_deadline ||
+                    (deadline == best_deadline && it->second < best->second)) {
+                best = it;
+                best_deadline = deadline;
+            }
+        }
+
+        Job* job = best->first;
+        std::chrono::duration<double, std::milli> waited = Clock::now() - best->second;
+        job->recordQueueWait(waited.count());
+
+        queued_.erase(best);
+        running_.insert(job);
+
+        return job;
+    }
+
+    void DecodeScheduler::loop() {
+        while (true) {
+            Job* job = nullptr;
+            {
+                std::unique_lock lk(mutex_);
+                work_cv_.wait(lk, [this]{ return stopping_ || !queued_.empty(); });
+
+                if (stopping_) {
+                    return;
+                }
+
+                job = pop();
+            }
+
+            // Jobs handle their own errors, but one that slips through must
+            // not take the worker (and with it the whole pool) down.
+            try {
+                job->work();
+            } catch (const std::exception& e) {
+                std::cerr << "WARNING: Decode job failed: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "WARNING: Decode job failed with an unknown error" << std::endl;
+            }
+
+            bool requeued = false;
+            {
+                std::lock_guard guard(mutex_);
+                running_.erase(job);
+
+                if (requeue_.count(job)) {
+                    queued_.emplace(job, requeue_.at(job));
+                    requeue_.erase(job);
+                    requeued = true;
+                }
+            }
+
+            done_cv_.notify_all();
+            if (requeued) {
+                work_cv_.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef VIDREVOLT_DECODESCHEDULER_H_
+#define VIDREVOLT_DECODESCHEDULER_H_
+
+// STL
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace vidrevolt {
+    // A single pool of decode workers, sized to the core count, shared by
+    // every Video. Queued jobs are ranked by deadline: the job that will
+    // run out of buffered frames soonest goes first.
+    class DecodeScheduler {
+        public:
+            using Clock = std::chrono::high_resolution_clock;
+
+            class Job {
+                public:
+                    struct WaitStats {
+                        double last_ms = 0;
+                        double avg_ms = 0;
+                        double max_ms = 0;
+                        size_t count = 0;
+                    };
+
+                    virtual ~Job() = default;
+
+                    // Milliseconds until playback runs past the buffered
+                    // frames. Called with the scheduler's lock held, so this
+                    // must not block. Infinity for idle (off-focus) jobs.
+                    virtual double getDeadlineMS() = 0;
+
+                    virtual void work() = 0;
+
+                    // Time spent queued before a worker picked the job up
+                    WaitStats getQueueWait() const;
+
+                private:
+                    friend class DecodeScheduler;
+
+                    void recordQueueWait(double ms);
+
+                    mutable std::mutex wait_mutex_;
+                    WaitStats wait_;
+            };
+
+            static DecodeScheduler& getInstance();
+
+            ~DecodeScheduler();
+
+            // Queue the job unless it is already queued. A job scheduled
+            // while it is running is queued again once it finishes.
+            void schedule(Job* job);
+
+            // Remove the job from the queue, waiting for it to finish if a
+            // worker is currently running it.
+            void cancel(Job* job);
+
+            size_t getWorkerCount() const;
+
+        private:
+            explicit DecodeScheduler(size_t workers);
+
+            void loop();
+            Job* pop();
+
+            std::mutex mutex_;
+            std::condition_variable work_cv_;
+            std::condition_variable done_cv_;
+
+            std::map<Job*, Clock::time_point> queued_;
+            std::set<Job*> running_;
+            std::map<Job*, Clock::time_point> requeue_;
+
+            std::vector<std::thread> workers_;
+            bool stopping_ = false;
+    };
+}
+
+#endif
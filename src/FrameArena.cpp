@@ -0,0 +1,93 @@
+#include "FrameArena.h"
+
+// STL
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+// POSIX
+#include <unistd.h>
+
+namespace vidrevolt {
+    FrameArena::FrameArena(size_t capacity, int rows, int cols, int type) :
+        capacity_(capacity), rows_(rows), cols_(cols), type_(type),
+        frame_bytes_(static_cast<size_t>(rows) * static_cast<size_t>(cols) * CV_ELEM_SIZE(type)) {
+
+        if (capacity_ == 0 || frame_bytes_ == 0) {
+            throw std::runtime_error("FrameArena requires at least one non-empty frame");
+        }
+
+        grow(capacity_);
+    }
+
+    void FrameArena::grow(size_t capacity) {
+        if (data_ != nullptr && capacity <= capacity_) {
+            return;
+        }
+
+        // aligned_alloc wants the size to be a multiple of the alignment
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t allocated = (capacity * frame_bytes_ + page_size - 1) / page_size * page_size;
+        auto data = static_cast<unsigned char*>(std::aligned_alloc(page_size, allocated));
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        if (data_ != nullptr) {
+            std::memcpy(data, data_, pts_.size() * frame_bytes_);
+            std::free(data_);
+        }
+
+        data_ = data;
+        allocated_ = allocated;
+        capacity_ = capacity;
+        pts_.reserve(capacity_);
+    }
+
+    FrameArena::~FrameArena() {
+        std::free(data_);
+    }
+
+    bool FrameArena::append(const cv::Mat& mat, double pts_ms) {
+        if (pts_.size() >= capacity_) {
+            return false;
+        }
+
+        if (mat.rows != rows_ || mat.cols != cols_ || mat.type() != type_) {
+            throw std::runtime_error("Frame does not match the shape of its FrameArena");
+        }
+
+        // Same shape, so copyTo writes straight into the slot
+        cv::Mat slot(rows_, cols_, type_, data_ + pts_.size() * frame_bytes_);
+        mat.copyTo(slot);
+
+        pts_.push_back(pts_ms);
+
+        return true;
+    }
+
+    cv::Mat FrameArena::at(size_t i) const {
+        if (i >= pts_.size()) {
+            throw std::out_of_range("FrameArena index out of range");
+        }
+
+        return cv::Mat(rows_, cols_, type_, data_ + i * frame_bytes_);
+    }
+
+    double FrameArena::ptsAt(size_t i) const {
+        if (i >= pts_.size()) {
+            throw std::out_of_range("FrameArena index out of range");
+        }
+
+        return pts_[i];
+    }
+
+    size_t FrameArena::size() const {
+        return pts_.size();
+    }
+
+    size_t FrameArena::bytes() const {
+        return allocated_;
+    }
+}
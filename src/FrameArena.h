@@ -0,0 +1,49 @@
+#ifndef VIDREVOLT_FRAMEARENA_H_
+#define VIDREVOLT_FRAMEARENA_H_
+
+// STL
+#include <vector>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+namespace vidrevolt {
+    // Every frame of a clip back to back in one page-aligned allocation,
+    // along with their timestamps. Frames are handed out as headers into
+    // the arena, so reading one is a pointer lookup.
+    class FrameArena {
+        public:
+            // Room for up to capacity frames of the given shape
+            FrameArena(size_t capacity, int rows, int cols, int type);
+            ~FrameArena();
+
+            FrameArena(const FrameArena&) = delete;
+            FrameArena& operator=(const FrameArena&) = delete;
+
+            // Copy a frame into the next slot. False once full.
+            bool append(const cv::Mat& mat, double pts_ms);
+
+            // Make room for up to capacity frames. This moves the frames,
+            // so only while none have been handed out.
+            void grow(size_t capacity);
+
+            cv::Mat at(size_t i) const;
+            double ptsAt(size_t i) const;
+
+            size_t size() const;
+            size_t bytes() const;
+
+        private:
+            size_t capacity_;
+            const int rows_;
+            const int cols_;
+            const int type_;
+            const size_t frame_bytes_;
+
+            unsigned char* data_ = nullptr;
+            size_t allocated_ = 0;
+            std::vector<double> pts_;
+    };
+}
+
+#endif
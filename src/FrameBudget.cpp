@@ -0,0 +1,87 @@
+#include "FrameBudget.h"
+
+// STL
+#include <algorithm>
+#include <vector>
+
+// Ours
+#include "Video.h"
+
+namespace vidrevolt {
+    FrameBudget& FrameBudget::getInstance() {
+        static FrameBudget budget;
+        return budget;
+    }
+
+    void FrameBudget::setLimit(size_t bytes) {
+        limit_ = bytes;
+        enforce();
+    }
+
+    size_t FrameBudget::getLimit() const {
+        return limit_.load();
+    }
+
+    size_t FrameBudget::getUsed() const {
+        std::lock_guard guard(mutex_);
+
+        size_t used = 0;
+        for (Video* vid : videos_) {
+            used += vid->getBufferedBytes();
+        }
+
+        return used;
+    }
+
+    void FrameBudget::add(Video* vid) {
+        std::lock_guard guard(mutex_);
+        videos_.insert(vid);
+    }
+
+    void FrameBudget::remove(Video* vid) {
+        std::lock_guard guard(mutex_);
+        videos_.erase(vid);
+    }
+
+    void FrameBudget::enforce() {
+        size_t limit = limit_.load();
+        if (limit == 0) {
+            return;
+        }
+
+        std::lock_guard guard(mutex_);
+
+        // Evictions already requested count as freed, so repeated calls
+        // while they are pending don't evict more than needed.
+        size_t used = 0;
+        std::vector<Video*> candidates;
+        for (Video* vid : videos_) {
+            if (vid->isEvictionPending()) {
+                continue;
+            }
+
+            used += vid->getBufferedBytes();
+            if (!vid->isInFocus() && vid->getBufferedBytes() > 0) {
+                candidates.push_back(vid);
+            }
+        }
+
+        if (used <= limit) {
+            return;
+        }
+
+        // Least recently used first
+        std::sort(candidates.begin(), candidates.end(), [](Video* a, Video* b) {
+            return a->getOutFocusSince() < b->getOutFocusSince();
+        });
+
+        for (Video* vid : candidates) {
+            if (used <= limit) {
+                break;
+            }
+
+            used -= vid->getBufferedBytes();
+            vid->requestEviction();
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef VIDREVOLT_FRAMEBUDGET_H_
+#define VIDREVOLT_FRAMEBUDGET_H_
+
+// STL
+#include <atomic>
+#include <mutex>
+#include <set>
+
+namespace vidrevolt {
+    class Video;
+
+    // Process-wide limit on memory held by Video frame buffers. When the
+    // total goes over, the buffers of the videos that have been out of focus
+    // the longest are dropped. They are rebuilt when the video comes back
+    // into focus.
+    class FrameBudget {
+        public:
+            static FrameBudget& getInstance();
+
+            // Zero means unlimited
+            void setLimit(size_t bytes);
+            size_t getLimit() const;
+
+            size_t getUsed() const;
+
+            void add(Video* vid);
+            void remove(Video* vid);
+
+            // Request evictions until the buffered total fits the limit.
+            void enforce();
+
+        private:
+            FrameBudget() = default;
+
+            std::atomic<size_t> limit_ = 0;
+
+            mutable std::mutex mutex_;
+            std::set<Video*> videos_;
+    };
+}
+
+#endif
@@ -0,0 +1,230 @@
+#include "FrameCache.h"
+
+// STL
+#include <chrono>
+#include <sstream>
+
+// LZ4
+#include "lz4.h"
+
+// Ours
+#include "FramePool.h"
+
+// Trades a little compression for speed, see LZ4_compress_fast()
+#define FRAME_CACHE_ACCELERATION 4
+
+namespace vidrevolt {
+    FrameCache& FrameCache::getInstance() {
+        static FrameCache cache;
+        return cache;
+    }
+
+    FrameCache::~FrameCache() {
+        {
+            std::lock_guard guard(mutex_);
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void FrameCache::setLimit(size_t bytes) {
+        limit_ = bytes;
+
+        std::lock_guard guard(mutex_);
+        shrink();
+    }
+
+    size_t FrameCache::getLimit() const {
+        return limit_.load();
+    }
+
+    bool FrameCache::isEnabled() const {
+        return limit_.load() > 0;
+    }
+
+    void FrameCache::put(const std::string& path, const decode::Frame& frame) {
+        // Frames that don't own their pixels (views of a clip's mapping)
+        // may be gone by the time the queue gets to them.
+        if (!isEnabled() || frame.mat.empty() || !frame.mat.isContinuous() || frame.mat.u == nullptr) {
+            return;
+        }
+
+        std::lock_guard guard(mutex_);
+        if (entries_.count(Key(path, frame.pos)) > 0) {
+            return;
+        }
+
+        // Better to miss a frame than to hold on to ever more of them
+        if (queue_.size() >= VIDREVOLT_FRAME_CACHE_QUEUE) {
+            stats_.dropped++;
+            return;
+        }
+
+        queue_.emplace_back(path, frame);
+
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&FrameCache::loop, this);
+        }
+
+        work_cv_.notify_one();
+    }
+
+    void FrameCache::loop() {
+        while (true) {
+            std::pair<std::string, decode::Frame> job;
+            {
+                std::unique_lock lk(mutex_);
+                work_cv_.wait(lk, [this]{ return stopping_ || !queue_.empty(); });
+                if (stopping_) {
+                    return;
+                }
+
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            compress(job.first, job.second);
+        }
+    }
+
+    void FrameCache::compress(const std::string& path, const decode::Frame& frame) {
+        Key key(path, frame.pos);
+        {
+            std::lock_guard guard(mutex_);
+            if (entries_.count(key) > 0) {
+                return;
+            }
+        }
+
+        // Compress outside the lock, it is by far the slowest part.
+        auto start = std::chrono::high_resolution_clock::now();
+
+        int raw_size = static_cast<int>(frame.mat.total() * frame.mat.elemSize());
+        std::vector<char> data(static_cast<size_t>(LZ4_compressBound(raw_size)));
+        int size = LZ4_compress_fast(reinterpret_cast<const char*>(frame.mat.data), data.data(),
+                raw_size, static_cast<int>(data.size()), FRAME_CACHE_ACCELERATION);
+        if (size <= 0) {
+            return;
+        }
+
+        data.resize(static_cast<size_t>(size));
+        data.shrink_to_fit();
+
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::high_resolution_clock::now() - start;
+
+        std::lock_guard guard(mutex_);
+        if (entries_.count(key) > 0) {
+            return;
+        }
+
+        lru_.push_front(key);
+
+        Entry& entry = entries_[key];
+        entry.data = std::make_shared<const std::vector<char>>(std::move(data));
+        entry.rows = frame.mat.rows;
+        entry.cols = frame.mat.cols;
+        entry.type = frame.mat.type();
+        entry.pts_ms = frame.pts_ms;
+        entry.lru = lru_.begin();
+
+        stats_.frames++;
+        stats_.bytes += static_cast<size_t>(size);
+        stats_.raw_bytes += static_cast<size_t>(raw_size);
+        stats_.compress_ms += elapsed.count();
+
+        shrink();
+    }
+
+    std::optional<decode::Frame> FrameCache::get(const std::string& path, int pos) {
+        if (!isEnabled()) {
+            return {};
+        }
+
+        decode::Frame frame;
+        std::shared_ptr<const std::vector<char>> data;
+        {
+            std::lock_guard guard(mutex_);
+
+            auto it = entries_.find(Key(path, pos));
+            if (it == entries_.end()) {
+                stats_.misses++;
+                return {};
+            }
+
+            Entry& entry = it->second;
+            lru_.splice(lru_.begin(), lru_, entry.lru);
+
+            data = entry.data;
+            frame.pos = pos;
+            frame.pts_ms = entry.pts_ms;
+            FramePool::assign(frame.mat);
+            frame.mat.create(entry.rows, entry.cols, entry.type);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        int raw_size = static_cast<int>(frame.mat.total() * frame.mat.elemSize());
+        int size = LZ4_decompress_safe(data->data(), reinterpret_cast<char*>(frame.mat.data),
+                static_cast<int>(data->size()), raw_size);
+
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::high_resolution_clock::now() - start;
+
+        std::lock_guard guard(mutex_);
+        if (size != raw_size) {
+            stats_.misses++;
+            return {};
+        }
+
+        stats_.hits++;
+        stats_.decompress_ms += elapsed.count();
+
+        return frame;
+    }
+
+    void FrameCache::shrink() {
+        size_t limit = limit_.load();
+        while (!lru_.empty() && stats_.bytes > limit) {
+            auto it = entries_.find(lru_.back());
+            const Entry& entry = it->second;
+
+            size_t raw_size = static_cast<size_t>(entry.rows) * static_cast<size_t>(entry.cols) *
+                CV_ELEM_SIZE(entry.type);
+            stats_.frames--;
+            stats_.bytes -= entry.data->size();
+            stats_.raw_bytes -= raw_size;
+
+            entries_.erase(it);
+            lru_.pop_back();
+        }
+    }
+
+    FrameCache::Stats FrameCache::getStats() const {
+        std::lock_guard guard(mutex_);
+        return stats_;
+    }
+
+    std::string FrameCache::str() const {
+        Stats stats = getStats();
+
+        double lookups = static_cast<double>(stats.hits + stats.misses);
+        double ratio = stats.bytes > 0 ? static_cast<double>(stats.raw_bytes) / static_cast<double>(stats.bytes) : 0;
+
+        std::ostringstream out;
+        out << "frame cache: frames=" << stats.frames <<
+            " used=" << stats.bytes / (1024 * 1024) << "MB" <<
+            " limit=" << getLimit() / (1024 * 1024) << "MB" <<
+            " ratio=" << ratio <<
+            " hit rate=" << (lookups > 0 ? static_cast<double>(stats.hits) / lookups * 100 : 0) << "%" <<
+            " compress=" << stats.compress_ms << "ms" <<
+            " decompress=" << stats.decompress_ms << "ms" <<
+            " dropped=" << stats.dropped << std::endl;
+
+        return out.str();
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef VIDREVOLT_FRAMECACHE_H_
+#define VIDREVOLT_FRAMECACHE_H_
+
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ours
+#include "decode/Frame.h"
+
+// Frames waiting to be compressed, more are dropped rather than queued
+#define VIDREVOLT_FRAME_CACHE_QUEUE 32
+
+namespace vidrevolt {
+    // Process-wide store of decoded frames compressed with LZ4, keyed by
+    // file and frame number. Sits between the Video buffers and the
+    // decoder: frames are added as they are decoded, and refills check
+    // here before seeking, so loops, reverse playback and jumps within a
+    // clip that has been played once cost a decompression instead of a
+    // decode. Least recently used frames go once over the byte limit.
+    // Compression happens on a thread of its own, off the decode path.
+    class FrameCache {
+        public:
+            struct Stats {
+                size_t hits = 0;
+                size_t misses = 0;
+                size_t frames = 0;
+                size_t bytes = 0;
+                size_t raw_bytes = 0;
+                double compress_ms = 0;
+                double decompress_ms = 0;
+
+                // Not cached because the compression queue was full
+                size_t dropped = 0;
+            };
+
+            static FrameCache& getInstance();
+
+            // Zero, the default, disables the cache
+            void setLimit(size_t bytes);
+            size_t getLimit() const;
+            bool isEnabled() const;
+
+            // Queue a frame to be compressed and stored unless it is
+            // already there. The frame's buffer is shared, not copied.
+            void put(const std::string& path, const decode::Frame& frame);
+
+            // Decompress a stored frame into a pooled cv::Mat.
+            std::optional<decode::Frame> get(const std::string& path, int pos);
+
+            Stats getStats() const;
+            std::string str() const;
+
+        private:
+            using Key = std::pair<std::string, int>;
+
+            struct Entry {
+                std::shared_ptr<const std::vector<char>> data;
+                int rows = 0;
+                int cols = 0;
+                int type = 0;
+                double pts_ms = 0;
+                std::list<Key>::iterator lru;
+            };
+
+            FrameCache() = default;
+            ~FrameCache();
+
+            void loop();
+            void compress(const std::string& path, const decode::Frame& frame);
+            void shrink();
+
+            std::atomic<size_t> limit_ = 0;
+
+            mutable std::mutex mutex_;
+            std::map<Key, Entry> entries_;
+
+            // Most recently used at the front
+            std::list<Key> lru_;
+
+            Stats stats_;
+
+            std::deque<std::pair<std::string, decode::Frame>> queue_;
+            std::condition_variable work_cv_;
+            std::thread thread_;
+            bool stopping_ = false;
+    };
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "FramePool.h"
+
+// STL
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+// POSIX
+#include <unistd.h>
+
+namespace vidrevolt {
+    FramePool::FramePool() : page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE))) {}
+
+    FramePool& FramePool::getInstance() {
+        static FramePool pool;
+        return pool;
+    }
+
+    void FramePool::assign(cv::Mat& mat) {
+        mat.allocator = &getInstance();
+    }
+
+    cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type, void* data0,
+            size_t* step, AccessFlag /*flags*/, cv::UMatUsageFlags /*usage*/) const {
+        // Mirrors cv::StdMatAllocator, only the buffer comes from take().
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) {
+                if (data0 && step[i] != CV_AUTOSTEP) {
+                    total = step[i];
+                } else {
+                    step[i] = total;
+                }
+            }
+
+            total *= static_cast<size_t>(sizes[i]);
+        }
+
+        auto u = new cv::UMatData(this);
+        u->size = total;
+        if (data0) {
+            u->data = u->origdata = static_cast<unsigned char*>(data0);
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+        } else {
+            u->data = u->origdata = take(total);
+        }
+
+        return u;
+    }
+
+    bool FramePool::allocate(cv::UMatData* u, AccessFlag /*flags*/, cv::UMatUsageFlags /*usage*/) const {
+        return u != nullptr;
+    }
+
+    void FramePool::deallocate(cv::UMatData* u) const {
+        if (u == nullptr) {
+            return;
+        }
+
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+            give(u->origdata, u->size);
+            u->origdata = nullptr;
+        }
+
+        delete u;
+    }
+
+    unsigned char* FramePool::take(size_t size) const {
+        {
+            std::lock_guard guard(mutex_);
+
+            Stats& stats = stats_[size];
+            stats.live++;
+            stats.peak = std::max(stats.peak, stats.live);
+
+            auto& free = free_[size];
+            if (!free.empty()) {
+                unsigned char* data = free.back();
+                free.pop_back();
+                stats.free = free.size();
+                stats.hits++;
+
+                return data;
+            }
+
+            stats.misses++;
+        }
+
+        // aligned_alloc wants the size to be a multiple of the alignment
+        size_t padded = (size + page_size_ - 1) / page_size_ * page_size_;
+        void* data = std::aligned_alloc(page_size_, padded);
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return static_cast<unsigned char*>(data);
+    }
+
+    void FramePool::give(unsigned char* data, size_t size) const {
+        std::lock_guard guard(mutex_);
+
+        Stats& stats = stats_[size];
+        stats.live--;
+
+        auto& free = free_[size];
+        free.push_back(data);
+        stats.free = free.size();
+    }
+
+    void FramePool::trim() {
+        std::lock_guard guard(mutex_);
+
+        for (auto& kv : free_) {
+            for (unsigned char* data : kv.second) {
+                std::free(data);
+            }
+
+            kv.second.clear();
+            stats_[kv.first].free = 0;
+        }
+    }
+
+    std::map<size_t, FramePool::Stats> FramePool::getStats() const {
+        std::lock_guard guard(mutex_);
+        return stats_;
+    }
+
+    std::string FramePool::str() const {
+        std::ostringstream out;
+        for (const auto& kv : getStats()) {
+            const Stats& stats = kv.second;
+            out << "frame pool " << kv.first << "B: live=" << stats.live <<
+                " peak=" << stats.peak << " free=" << stats.free <<
+                " hits=" << stats.hits << " misses=" << stats.misses << std::endl;
+        }
+
+        return out.str();
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef VIDREVOLT_FRAMEPOOL_H_
+#define VIDREVOLT_FRAMEPOOL_H_
+
+// STL
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+namespace vidrevolt {
+    // Recycling allocator for decoded frames. Any cv::Mat pointed at the pool
+    // (see assign) takes a page-aligned buffer from a free list of the same
+    // size, and hands it back when the last reference to it goes away, e.g.
+    // when a Video buffer slot is overwritten. Frames of one resolution and
+    // type all share a size, so each free list is effectively per-resolution.
+    class FramePool : public cv::MatAllocator {
+        public:
+#if CV_VERSION_MAJOR >= 4
+            using AccessFlag = cv::AccessFlag;
+#else
+            using AccessFlag = int;
+#endif
+
+            struct Stats {
+                size_t live = 0;
+                size_t peak = 0;
+                size_t free = 0;
+                size_t hits = 0;
+                size_t misses = 0;
+            };
+
+            static FramePool& getInstance();
+
+            // Make the next allocation of mat come from the pool.
+            static void assign(cv::Mat& mat);
+
+            cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                    size_t* step, AccessFlag flags, cv::UMatUsageFlags usage) const override;
+            bool allocate(cv::UMatData* data, AccessFlag flags, cv::UMatUsageFlags usage) const override;
+            void deallocate(cv::UMatData* data) const override;
+
+            // Counters keyed by buffer size in bytes
+            std::map<size_t, Stats> getStats() const;
+            std::string str() const;
+
+            // Release every buffer not currently in use.
+            void trim();
+
+        private:
+            FramePool();
+
+            unsigned char* take(size_t size) const;
+            void give(unsigned char* data, size_t size) const;
+
+            const size_t page_size_;
+
+            mutable std::mutex mutex_;
+            mutable std::map<size_t, std::vector<unsigned char*>> free_;
+            mutable std::map<size_t, Stats> stats_;
+    };
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "FrameRing.h"
+
+// STL
+#include <algorithm>
+#include <stdexcept>
+
+namespace vidrevolt {
+    FrameRing::FrameRing(size_t capacity) : positions_(capacity, -1), pts_(capacity, 0), mats_(capacity) {
+        if (capacity == 0) {
+            throw std::runtime_error("FrameRing requires a capacity greater than zero");
+        }
+    }
+
+    void FrameRing::pushBack(Frame frame) {
+        if (full()) {
+            head_ = (head_ + 1) % capacity();
+        } else {
+            size_++;
+        }
+
+        positions_[tail_] = frame.pos;
+        pts_[tail_] = frame.pts_ms;
+        mats_[tail_] = frame.mat;
+        tail_ = (tail_ + 1) % capacity();
+    }
+
+    void FrameRing::pushFront(Frame frame) {
+        if (full()) {
+            tail_ = (tail_ + capacity() - 1) % capacity();
+        } else {
+            size_++;
+        }
+
+        head_ = (head_ + capacity() - 1) % capacity();
+        positions_[head_] = frame.pos;
+        pts_[head_] = frame.pts_ms;
+        mats_[head_] = frame.mat;
+    }
+
+    FrameRing::Frame FrameRing::at(size_t i) const {
+        if (i >= size_) {
+            throw std::out_of_range("FrameRing index out of range");
+        }
+
+        size_t s = slot(i);
+        return Frame{positions_[s], pts_[s], mats_[s]};
+    }
+
+    FrameRing::Frame FrameRing::front() const {
+        return at(0);
+    }
+
+    FrameRing::Frame FrameRing::back() const {
+        return at(size_ - 1);
+    }
+
+    int FrameRing::posAt(size_t i) const {
+        if (i >= size_) {
+            throw std::out_of_range("FrameRing index out of range");
+        }
+
+        return positions_[slot(i)];
+    }
+
+    double FrameRing::ptsAt(size_t i) const {
+        if (i >= size_) {
+            throw std::out_of_range("FrameRing index out of range");
+        }
+
+        return pts_[slot(i)];
+    }
+
+    std::optional<size_t> FrameRing::find(int pos) const {
+        for (size_t i = 0; i < size_; i++) {
+            if (positions_[slot(i)] == pos) {
+                return i;
+            }
+        }
+
+        return {};
+    }
+
+    size_t FrameRing::size() const {
+        return size_;
+    }
+
+    size_t FrameRing::capacity() const {
+        return mats_.size();
+    }
+
+    bool FrameRing::empty() const {
+        return size_ == 0;
+    }
+
+    bool FrameRing::full() const {
+        return size_ == capacity();
+    }
+
+    size_t FrameRing::bytes() const {
+        size_t total = 0;
+        for (const auto& mat : mats_) {
+            total += mat.total() * mat.elemSize();
+        }
+
+        return total;
+    }
+
+    void FrameRing::clear() {
+        for (auto& mat : mats_) {
+            mat.release();
+        }
+
+        std::fill(positions_.begin(), positions_.end(), -1);
+        head_ = 0;
+        tail_ = 0;
+        size_ = 0;
+    }
+
+    void FrameRing::setCapacity(size_t capacity, size_t keep_from) {
+        if (capacity == 0) {
+            throw std::runtime_error("FrameRing requires a capacity greater than zero");
+        }
+
+        std::vector<int> positions(capacity, -1);
+        std::vector<double> pts(capacity, 0);
+        std::vector<cv::Mat> mats(capacity);
+
+        size_t kept = 0;
+        for (size_t i = keep_from; i < size_ && kept < capacity; i++, kept++) {
+            positions[kept] = positions_[slot(i)];
+            pts[kept] = pts_[slot(i)];
+            mats[kept] = mats_[slot(i)];
+        }
+
+        positions_ = std::move(positions);
+        pts_ = std::move(pts);
+        mats_ = std::move(mats);
+        head_ = 0;
+        tail_ = kept % capacity;
+        size_ = kept;
+    }
+
+    size_t FrameRing::slot(size_t i) const {
+        return (head_ + i) % capacity();
+    }
+}
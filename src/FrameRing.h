@@ -0,0 +1,71 @@
+#ifndef VIDREVOLT_FRAMERING_H_
+#define VIDREVOLT_FRAMERING_H_
+
+// STL
+#include <optional>
+#include <vector>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "decode/Frame.h"
+
+namespace vidrevolt {
+    // Fixed capacity ring of decoded frames. Logical index 0 is the front
+    // (oldest when playing forward). Pushing onto a full ring overwrites the
+    // slot at the opposite end, so existing frames are never moved.
+    class FrameRing {
+        public:
+            using Frame = decode::Frame;
+
+            explicit FrameRing(size_t capacity);
+
+            // Append after the back, overwriting the front if full.
+            void pushBack(Frame frame);
+
+            // Prepend before the front, overwriting the back if full.
+            void pushFront(Frame frame);
+
+            Frame at(size_t i) const;
+            Frame front() const;
+            Frame back() const;
+
+            // Frame number stored in the slot at logical index i
+            int posAt(size_t i) const;
+
+            // Presentation timestamp stored in the slot at logical index i
+            double ptsAt(size_t i) const;
+
+            // Logical index of the slot holding the given frame number
+            std::optional<size_t> find(int pos) const;
+
+            size_t size() const;
+            size_t capacity() const;
+            bool empty() const;
+            bool full() const;
+
+            // Total size of the buffered pixel data
+            size_t bytes() const;
+
+            void clear();
+
+            // Reallocate with a new capacity, keeping the frames from
+            // logical index keep_from onwards (as many as fit).
+            void setCapacity(size_t capacity, size_t keep_from = 0);
+
+        private:
+            size_t slot(size_t i) const;
+
+            std::vector<int> positions_;
+            std::vector<double> pts_;
+            std::vector<cv::Mat> mats_;
+
+            // Physical index of the front slot and one past the back slot.
+            size_t head_ = 0;
+            size_t tail_ = 0;
+            size_t size_ = 0;
+    };
+}
+
+#endif
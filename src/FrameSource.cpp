@@ -1,4 +1,32 @@
 #include "FrameSource.h"
 
 namespace vidrevolt {
+    FrameSource::PixelFormat FrameSource::getPixelFormat() const {
+        return BGR;
+    }
+
+    bool FrameSource::isBlending() const {
+        return false;
+    }
+
+    std::optional<FrameSource::Blend> FrameSource::nextBlend() {
+        std::optional<cv::Mat> frame = nextFrame();
+        if (!frame) {
+            return {};
+        }
+
+        Blend blend;
+        blend.from = frame.value();
+        blend.to = frame.value();
+
+        return blend;
+    }
+
+    cv::Size FrameSource::imageSize(const cv::Mat& frame, PixelFormat format) {
+        if (format == NV12) {
+            return cv::Size(frame.cols, frame.rows * 2 / 3);
+        }
+
+        return frame.size();
+    }
 }
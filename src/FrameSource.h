@@ -10,7 +10,42 @@
 namespace vidrevolt {
     class FrameSource {
         public:
+            // Layout of the frames nextFrame() hands out, top row first
+            // either way, as OpenCV has them. Flipping for OpenGL is left
+            // to texture coordinates.
+            enum PixelFormat {
+                // CV_8UC3, uploaded as is with the channels swizzled
+                BGR,
+
+                // CV_8UC1 with height * 3 / 2 rows: the Y plane followed
+                // by interleaved half resolution UV, converted on the GPU
+                NV12
+            };
+
+            // Two neighbouring frames and how far playback has got from
+            // one to the other, shown as from * (1 - mix) + to * mix. The
+            // frame numbers let the receiver keep frames it already has,
+            // -1 if there are none.
+            struct Blend {
+                cv::Mat from;
+                cv::Mat to;
+                int from_pos = -1;
+                int to_pos = -1;
+                double mix = 0;
+            };
+
             virtual std::optional<cv::Mat> nextFrame() = 0;
+
+            // Sources that interpolate are read through nextBlend() instead
+            // of nextFrame(), and every render since the mix moves on even
+            // while the frames stay the same. Empty holds the last one.
+            virtual bool isBlending() const;
+            virtual std::optional<Blend> nextBlend();
+
+            virtual PixelFormat getPixelFormat() const;
+
+            // Width and height of the image in a frame of the given format
+            static cv::Size imageSize(const cv::Mat& frame, PixelFormat format);
     };
 }
 #endif
@@ -9,9 +9,7 @@ namespace vidrevolt {
             throw std::runtime_error("Unable to load image " + path);
         }
 
-        cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
-        flip(image, image, 0);
-
+        // Uploaded as is, see FrameSource::PixelFormat
         return image;
     }
 }
@@ -0,0 +1,149 @@
+#include "KeyframeIndex.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// FFmpeg
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace vidrevolt {
+    KeyframeIndex::KeyframeIndex(const std::string& path) : path_(path) {}
+
+    KeyframeIndex::~KeyframeIndex() {
+        cancelled_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void KeyframeIndex::buildAsync(std::function<void(const std::vector<int>&)> on_built) {
+        if (ready_.load() || thread_.joinable()) {
+            return;
+        }
+
+        thread_ = std::thread([this, on_built]() {
+            std::vector<int> keyframes = scan();
+            if (keyframes.empty()) {
+                return;
+            }
+
+            load(keyframes);
+
+            // What the file holds, even if replace() got in first
+            if (on_built) {
+                on_built(keyframes);
+            }
+        });
+    }
+
+    std::vector<int> KeyframeIndex::scan() {
+        AVFormatContext* fmt = nullptr;
+        if (avformat_open_input(&fmt, path_.c_str(), nullptr, nullptr) < 0) {
+            std::cerr << "WARNING: Unable to index keyframes of " << path_ << std::endl;
+            return {};
+        }
+
+        if (avformat_find_stream_info(fmt, nullptr) < 0) {
+            std::cerr << "WARNING: Unable to index keyframes of " << path_ << std::endl;
+            avformat_close_input(&fmt);
+            return {};
+        }
+
+        int stream_idx = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream_idx < 0) {
+            avformat_close_input(&fmt);
+            return {};
+        }
+
+        AVStream* stream = fmt->streams[stream_idx];
+        double fps = av_q2d(av_guess_frame_rate(fmt, stream, nullptr));
+        double time_base = av_q2d(stream->time_base);
+        int64_t start = stream->start_time == AV_NOPTS_VALUE ? 0 : stream->start_time;
+
+        // Frame numbers are derived from timestamps the same way
+        // cv::VideoCapture reports CAP_PROP_POS_FRAMES.
+        std::vector<int> keyframes;
+        AVPacket* pkt = av_packet_alloc();
+        while (!cancelled_.load() && av_read_frame(fmt, pkt) >= 0) {
+            if (pkt->stream_index == stream_idx && (pkt->flags & AV_PKT_FLAG_KEY)) {
+                int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+                if (ts != AV_NOPTS_VALUE) {
+                    keyframes.push_back(static_cast<int>(std::lround(
+                                static_cast<double>(ts - start) * time_base * fps)));
+                }
+            }
+
+            av_packet_unref(pkt);
+        }
+
+        av_packet_free(&pkt);
+        avformat_close_input(&fmt);
+
+        if (cancelled_.load()) {
+            return {};
+        }
+
+        return keyframes;
+    }
+
+    void KeyframeIndex::build() {
+        std::vector<int> keyframes = scan();
+        if (!keyframes.empty()) {
+            load(keyframes);
+        }
+    }
+
+    void KeyframeIndex::load(std::vector<int> keyframes) {
+        std::lock_guard guard(write_mutex_);
+        if (ready_.load()) {
+            return;
+        }
+
+        install(std::move(keyframes));
+    }
+
+    void KeyframeIndex::replace(std::vector<int> keyframes) {
+        std::lock_guard guard(write_mutex_);
+        install(std::move(keyframes));
+    }
+
+    void KeyframeIndex::install(std::vector<int> keyframes) {
+        std::sort(keyframes.begin(), keyframes.end());
+        keyframes.erase(std::unique(keyframes.begin(), keyframes.end()), keyframes.end());
+
+        // Readers hold on to whichever table they started with
+        std::atomic_store(&keyframes_, std::make_shared<const std::vector<int>>(std::move(keyframes)));
+        ready_ = true;
+    }
+
+    bool KeyframeIndex::isReady() const {
+        return ready_.load();
+    }
+
+    int KeyframeIndex::keyframeBefore(int pos) const {
+        std::shared_ptr<const std::vector<int>> keyframes = std::atomic_load(&keyframes_);
+        if (keyframes == nullptr) {
+            return 0;
+        }
+
+        auto it = std::upper_bound(keyframes->begin(), keyframes->end(), pos);
+        if (it == keyframes->begin()) {
+            return 0;
+        }
+
+        return *(it - 1);
+    }
+
+    std::vector<int> KeyframeIndex::getKeyframes() const {
+        std::shared_ptr<const std::vector<int>> keyframes = std::atomic_load(&keyframes_);
+        if (keyframes == nullptr) {
+            return {};
+        }
+
+        return *keyframes;
+    }
+}
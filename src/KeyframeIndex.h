@@ -0,0 +1,58 @@
+#ifndef VIDREVOLT_KEYFRAMEINDEX_H_
+#define VIDREVOLT_KEYFRAMEINDEX_H_
+
+// STL
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vidrevolt {
+    // Frame numbers of every keyframe in a video, found by demuxing the
+    // container (no decoding). Lets refills seek straight to the start of a
+    // GOP and read it whole instead of paying for a hidden decode from the
+    // previous keyframe on every seek.
+    class KeyframeIndex {
+        public:
+            explicit KeyframeIndex(const std::string& path);
+            ~KeyframeIndex();
+
+            // Build on a background thread; isReady() flips once done and
+            // on_built, if given, is called from that thread with the result.
+            void buildAsync(std::function<void(const std::vector<int>&)> on_built = nullptr);
+            void build();
+
+            // Use a previously built list instead of scanning the file.
+            void load(std::vector<int> keyframes);
+
+            // Swap in a different list even when one is in use already,
+            // e.g. once frames come from an all-keyframe proxy. Safe while
+            // other threads call keyframeBefore().
+            void replace(std::vector<int> keyframes);
+
+            bool isReady() const;
+
+            // Latest keyframe at or before pos. Only valid once ready.
+            int keyframeBefore(int pos) const;
+
+            std::vector<int> getKeyframes() const;
+
+        private:
+            std::vector<int> scan();
+            void install(std::vector<int> keyframes);
+
+            const std::string path_;
+
+            // Swapped whole with std::atomic_load/atomic_store
+            std::shared_ptr<const std::vector<int>> keyframes_;
+            std::mutex write_mutex_;
+            std::atomic<bool> ready_ = false;
+            std::atomic<bool> cancelled_ = false;
+            std::thread thread_;
+    };
+}
+
+#endif
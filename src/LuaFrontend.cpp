@@ -33,6 +33,7 @@ namespace vidrevolt {
         // Our custom functions
         lua_.set_function("Video", &LuaFrontend::luafunc_Video, this);
         lua_.set_function("Webcam", &LuaFrontend::luafunc_Webcam, this);
+        lua_.set_function("Playlist", &LuaFrontend::luafunc_Playlist, this);
         lua_.set_function("Image", &LuaFrontend::luafunc_Image, this);
         lua_.set_function("OSC", &LuaFrontend::luafunc_OSC, this);
         lua_.set_function("BPM", &LuaFrontend::luafunc_BPM, this);
@@ -40,10 +41,19 @@ namespace vidrevolt {
         lua_.set_function("Midi", &LuaFrontend::luafunc_Midi, this);
         lua_.set_function("rend", &LuaFrontend::luafunc_rend, this);
         lua_.set_function("getControlValues", &LuaFrontend::luafunc_getControlValues, this);
+        lua_.set_function("videoStats", &LuaFrontend::luafunc_videoStats, this);
         lua_.set_function("tap", &LuaFrontend::luafunc_tap, this);
         //lua_.set_function("preload", &LuaFrontend::luafunc_preload, this);
         lua_.set_function("flipPlayback", &LuaFrontend::luafunc_flipPlayback, this);
         lua_.set_function("setFPS", &LuaFrontend::luafunc_setFPS, this);
+        lua_.set_function("seek", &LuaFrontend::luafunc_seek, this);
+        lua_.set_function("scrub", &LuaFrontend::luafunc_scrub, this);
+        lua_.set_function("cue", &LuaFrontend::luafunc_cue, this);
+        lua_.set_function("setFrameBudget", &LuaFrontend::luafunc_setFrameBudget, this);
+        lua_.set_function("setFrameCache", &LuaFrontend::luafunc_setFrameCache, this);
+        lua_.set_function("setProxies", &LuaFrontend::luafunc_setProxies, this);
+        lua_.set_function("setLazyOpen", &LuaFrontend::luafunc_setLazyOpen, this);
+        lua_.set_function("prefetch", &LuaFrontend::luafunc_prefetch, this);
         lua_.set_function("playAudio", &LuaFrontend::luafunc_playAudio, this);
         lua_.set_function("restartAudio", &LuaFrontend::luafunc_restartAudio, this);
         lua_.set_function("rando", &LuaFrontend::luafunc_rando, this);
@@ -118,12 +128,83 @@ namespace vidrevolt {
         return pipeline_->addWebcam(device);
     }
 
+    Video::Options LuaFrontend::defaultVideoOptions() {
+        Video::Options opts;
+
+        // The pipeline isn't loaded until the script finishes, so go by
+        // the same globals it will be loaded with.
+        opts.target.width = lua_.get_or("width", 1920);
+        opts.target.height = lua_.get_or("height", 1080);
+
+        return opts;
+    }
+
+    bool LuaFrontend::parseVideoOption(const std::string& key, const sol::object& value,
+            Video::Options& opts, bool& downscale) {
+        if (key == "depth") {
+            int depth = value.as<int>();
+            if (depth <= 0) {
+                throw std::runtime_error("Video depth must be positive");
+            }
+
+            opts.buffer_depth = static_cast<size_t>(depth);
+        } else if (key == "threshold") {
+            opts.refill_threshold = value.as<int>();
+        } else if (key == "adaptive") {
+            opts.adaptive = value.as<bool>();
+        } else if (key == "index") {
+            opts.keyframe_index = value.as<bool>();
+        } else if (key == "backend") {
+            opts.backend = decode::Backend::typeFromString(value.as<std::string>());
+        } else if (key == "preload") {
+            opts.preload = value.as<bool>();
+        } else if (key == "width") {
+            opts.target.width = value.as<int>();
+        } else if (key == "height") {
+            opts.target.height = value.as<int>();
+        } else if (key == "yuv") {
+            opts.pixel_format = value.as<bool>() ? Video::NV12 : Video::BGR;
+        } else if (key == "downscale") {
+            downscale = value.as<bool>();
+        } else if (key == "blend") {
+            opts.blend = value.as<bool>();
+        } else if (key == "cues") {
+            // e.g. cues={drop=12.5, outro=90}, in seconds
+            for (const auto& cue : value.as<sol::table>()) {
+                opts.cues[cue.first.as<std::string>()] = cue.second.as<double>();
+            }
+        } else if (key == "cue_frames") {
+            int frames = value.as<int>();
+            if (frames < 0) {
+                throw std::runtime_error("Video cue_frames must be zero (don't pin) or more");
+            }
+
+            opts.cue_frames = static_cast<size_t>(frames);
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+
     LuaFrontend::ObjID LuaFrontend::luafunc_Video(const std::string& path, const sol::table& args) {
         Video::Playback pb = Video::Forward;
+        Video::Options opts = defaultVideoOptions();
         bool auto_reset = false;
+        bool downscale = true;
 
         if (args) {
             for (const auto& arg : args) {
+                // Named options, e.g. Video(path, {"mirror", depth=60})
+                if (arg.first.is<std::string>()) {
+                    auto key = arg.first.as<std::string>();
+                    if (!parseVideoOption(key, arg.second, opts, downscale)) {
+                        throw std::runtime_error("Unexpected Video option " + key);
+                    }
+
+                    continue;
+                }
+
                 auto arg_s = arg.second.as<std::string>();
                 if (arg_s == "reverse") {
                     pb = Video::Reverse;
@@ -133,13 +214,65 @@ namespace vidrevolt {
                     pb = Video::Mirror;
                 } else if (arg_s == "reset") {
                     auto_reset = true;
+                } else if (arg_s == "adaptive") {
+                    opts.adaptive = true;
+                } else if (arg_s == "preload") {
+                    opts.preload = true;
+                } else if (arg_s == "yuv") {
+                    opts.pixel_format = Video::NV12;
+                } else if (arg_s == "blend") {
+                    opts.blend = true;
                 } else {
                     throw std::runtime_error("Unexpected Video argument " + arg_s);
                 }
             }
         }
 
-        return pipeline_->addVideo(path, auto_reset, pb);
+        if (!downscale) {
+            opts.target = Resolution();
+        }
+
+        return pipeline_->addVideo(path, auto_reset, pb, opts);
+    }
+
+    LuaFrontend::ObjID LuaFrontend::luafunc_Playlist(const sol::table& paths, const sol::table& args) {
+        std::vector<std::string> clips;
+        for (const auto& kv : paths) {
+            clips.push_back(kv.second.as<std::string>());
+        }
+
+        Video::Options opts = defaultVideoOptions();
+        bool loop = false;
+        bool downscale = true;
+
+        if (args) {
+            for (const auto& arg : args) {
+                // Named options as for Video, e.g. Playlist({a, b}, {"loop", depth=60})
+                if (arg.first.is<std::string>()) {
+                    auto key = arg.first.as<std::string>();
+                    if (!parseVideoOption(key, arg.second, opts, downscale)) {
+                        throw std::runtime_error("Unexpected Playlist option " + key);
+                    }
+
+                    continue;
+                }
+
+                auto arg_s = arg.second.as<std::string>();
+                if (arg_s == "loop") {
+                    loop = true;
+                } else if (arg_s == "yuv") {
+                    opts.pixel_format = Video::NV12;
+                } else {
+                    throw std::runtime_error("Unexpected Playlist argument " + arg_s);
+                }
+            }
+        }
+
+        if (!downscale) {
+            opts.target = Resolution();
+        }
+
+        return pipeline_->addPlaylist(clips, opts, loop);
     }
 
     sol::table LuaFrontend::luafunc_getControlValues(const ObjID& controller_id) {
@@ -158,6 +291,30 @@ namespace vidrevolt {
         return ret;
     }
 
+    sol::table LuaFrontend::luafunc_videoStats(const std::string& id) {
+        Video::Stats stats = pipeline_->getVideoStats(id);
+
+        // Enough for a script to notice a clip struggling and back off
+        sol::table ret = lua_.create_table_with();
+        ret["underruns"] = stats.underruns;
+        ret["refills"] = stats.refills;
+        ret["refill_last_ms"] = stats.refill_last_ms;
+        ret["refill_avg_ms"] = stats.refill_avg_ms;
+        ret["refill_max_ms"] = stats.refill_max_ms;
+        ret["seeks"] = stats.seeks;
+        ret["seek_latency_avg_ms"] = stats.seek_latency_avg_ms;
+        ret["decode_fps"] = stats.decode_fps;
+        ret["dropped"] = stats.playback.dropped;
+        ret["depth"] = stats.buffer_depth;
+        ret["buffered"] = stats.buffered_frames;
+        ret["ahead"] = stats.frames_ahead;
+        ret["fill"] = stats.buffer_depth > 0 ?
+            static_cast<double>(stats.buffered_frames) / static_cast<double>(stats.buffer_depth) : 0;
+        ret["in_focus"] = stats.in_focus;
+
+        return ret;
+    }
+
     std::string LuaFrontend::luafunc_rend(const std::string& target, const std::string& path, sol::table inputs) {
         gl::ParamSet params;
         std::vector<Address> deps;
@@ -233,6 +390,43 @@ namespace vidrevolt {
         pipeline_->setFPS(id, fps);
     }
 
+    void LuaFrontend::luafunc_seek(const std::string& id, double pos, sol::optional<std::string> unit) {
+        std::string unit_s = unit.value_or("seconds");
+        if (unit_s != "seconds" && unit_s != "frames") {
+            throw std::runtime_error("Unexpected seek unit " + unit_s + ", expected seconds or frames");
+        }
+
+        pipeline_->seek(id, pos, unit_s == "frames");
+    }
+
+    void LuaFrontend::luafunc_scrub(const std::string& id, double amount) {
+        pipeline_->scrub(id, amount);
+    }
+
+    void LuaFrontend::luafunc_cue(const std::string& id, const std::string& name) {
+        pipeline_->cue(id, name);
+    }
+
+    void LuaFrontend::luafunc_setFrameBudget(int mb) {
+        pipeline_->setFrameBudget(mb);
+    }
+
+    void LuaFrontend::luafunc_setFrameCache(int mb) {
+        pipeline_->setFrameCache(mb);
+    }
+
+    void LuaFrontend::luafunc_setProxies(bool enabled, sol::optional<int> height) {
+        pipeline_->setProxies(enabled, height.value_or(0));
+    }
+
+    void LuaFrontend::luafunc_setLazyOpen(bool enabled) {
+        pipeline_->setLazyOpen(enabled);
+    }
+
+    void LuaFrontend::luafunc_prefetch(const std::string& id) {
+        pipeline_->prefetch(id);
+    }
+
     void LuaFrontend::luafunc_flipPlayback(const std::string& id) {
         pipeline_->flipPlayback(id);
     }
@@ -22,7 +22,13 @@ namespace vidrevolt {
         private:
             AddressOrValue toAOV(const sol::object& obj);
 
+            // Options shared by Video() and Playlist()
+            Video::Options defaultVideoOptions();
+            bool parseVideoOption(const std::string& key, const sol::object& value,
+                    Video::Options& opts, bool& downscale);
+
             ObjID luafunc_Video(const std::string& path, const sol::table& args);
+            ObjID luafunc_Playlist(const sol::table& paths, const sol::table& args);
             ObjID luafunc_Webcam(int device);
             ObjID luafunc_Image(const std::string& path);
             ObjID luafunc_Keyboard();
@@ -30,10 +36,19 @@ namespace vidrevolt {
             ObjID luafunc_OSC(const std::string& path, int port);
             ObjID luafunc_Midi(const std::string& path);
             sol::table luafunc_getControlValues(const ObjID& controller_id);
+            sol::table luafunc_videoStats(const std::string& id);
             std::string luafunc_rend(const std::string& target, const std::string& path, sol::table inputs);
             void luafunc_flipPlayback(const std::string& id);
             void luafunc_tap(const std::string& sync_id);
             void luafunc_setFPS(const std::string& id, double fps);
+            void luafunc_seek(const std::string& id, double pos, sol::optional<std::string> unit);
+            void luafunc_scrub(const std::string& id, double amount);
+            void luafunc_cue(const std::string& id, const std::string& name);
+            void luafunc_setFrameBudget(int mb);
+            void luafunc_setFrameCache(int mb);
+            void luafunc_setProxies(bool enabled, sol::optional<int> height);
+            void luafunc_setLazyOpen(bool enabled);
+            void luafunc_prefetch(const std::string& id);
             void luafunc_playAudio(const std::string& path);
             void luafunc_restartAudio();
             float luafunc_rando();
@@ -0,0 +1,143 @@
+#include "MetadataCache.h"
+
+// STL
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+// Boost
+#include <boost/filesystem.hpp>
+
+// yaml-cpp
+#include "yaml-cpp/yaml.h"
+
+#define METADATA_CACHE_VERSION 1
+#define METADATA_CACHE_EXT ".vrmeta"
+
+namespace fs = boost::filesystem;
+
+namespace vidrevolt {
+    std::vector<std::string> MetadataCache::candidatePaths(const std::string& path) {
+        // Preferred: under ~/.cache, rather than next to the user's media
+        std::vector<std::string> paths;
+
+        const char* home = std::getenv("HOME");
+        if (home != nullptr) {
+            std::ostringstream name;
+            name << std::hex << std::hash<std::string>{}(fs::absolute(path).string()) << METADATA_CACHE_EXT;
+            paths.push_back((fs::path(home) / ".cache" / "vidrevolt" / name.str()).string());
+        }
+
+        // The sidecar is the fallback, for reading an entry the home one
+        // doesn't have and for writing when the home one can't be written.
+        paths.push_back(path + METADATA_CACHE_EXT);
+
+        return paths;
+    }
+
+    std::optional<MetadataCache::Entry> MetadataCache::load(const std::string& path) {
+        boost::system::error_code ec;
+        auto size = fs::file_size(path, ec);
+        if (ec) {
+            return {};
+        }
+
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) {
+            return {};
+        }
+
+        for (const auto& cache_path : candidatePaths(path)) {
+            if (!fs::exists(cache_path, ec)) {
+                continue;
+            }
+
+            try {
+                YAML::Node node = YAML::LoadFile(cache_path);
+                if (node["version"].as<int>() != METADATA_CACHE_VERSION ||
+                        node["source"].as<std::string>() != fs::absolute(path).string() ||
+                        node["size"].as<uintmax_t>() != size ||
+                        node["mtime"].as<int64_t>() != static_cast<int64_t>(mtime)) {
+                    continue;
+                }
+
+                Entry entry;
+                entry.metadata.frame_count = node["frame_count"].as<int>();
+                entry.metadata.fps = node["fps"].as<double>();
+                entry.metadata.duration_ms = node["duration_ms"].as<double>();
+                entry.metadata.resolution.width = node["width"].as<int>();
+                entry.metadata.resolution.height = node["height"].as<int>();
+                if (node["keyframes"]) {
+                    entry.keyframes = node["keyframes"].as<std::vector<int>>();
+                }
+
+                return entry;
+            } catch (const YAML::Exception& e) {
+                std::cerr << "WARNING: Ignoring unreadable metadata cache " << cache_path <<
+                    ": " << e.what() << std::endl;
+            }
+        }
+
+        return {};
+    }
+
+    void MetadataCache::store(const std::string& path, const Entry& entry) {
+        boost::system::error_code ec;
+        auto size = fs::file_size(path, ec);
+        if (ec) {
+            return;
+        }
+
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) {
+            return;
+        }
+
+        YAML::Emitter out;
+        out << YAML::BeginMap;
+        out << YAML::Key << "version" << YAML::Value << METADATA_CACHE_VERSION;
+        out << YAML::Key << "source" << YAML::Value << fs::absolute(path).string();
+        out << YAML::Key << "size" << YAML::Value << size;
+        out << YAML::Key << "mtime" << YAML::Value << static_cast<int64_t>(mtime);
+        out << YAML::Key << "frame_count" << YAML::Value << entry.metadata.frame_count;
+        out << YAML::Key << "fps" << YAML::Value << entry.metadata.fps;
+        out << YAML::Key << "duration_ms" << YAML::Value << entry.metadata.duration_ms;
+        out << YAML::Key << "width" << YAML::Value << entry.metadata.resolution.width;
+        out << YAML::Key << "height" << YAML::Value << entry.metadata.resolution.height;
+        if (!entry.keyframes.empty()) {
+            out << YAML::Key << "keyframes" << YAML::Value << YAML::Flow << entry.keyframes;
+        }
+        out << YAML::EndMap;
+
+        // Probing and keyframe indexing both store entries, possibly for
+        // the same video at once. Writes are rare, so one lock serialises
+        // them all.
+        static std::mutex write_mutex;
+        std::lock_guard guard(write_mutex);
+
+        // First location we can write to wins
+        for (const auto& cache_path : candidatePaths(path)) {
+            fs::create_directories(fs::path(cache_path).parent_path(), ec);
+
+            std::string tmp_path = cache_path + ".tmp";
+            {
+                std::ofstream ofs(tmp_path);
+                if (!ofs || !(ofs << out.c_str() << std::endl)) {
+                    continue;
+                }
+            }
+
+            fs::rename(tmp_path, cache_path, ec);
+            if (!ec) {
+                return;
+            }
+
+            fs::remove(tmp_path, ec);
+        }
+
+        std::cerr << "WARNING: Unable to write metadata cache for " << path << std::endl;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef VIDREVOLT_METADATACACHE_H_
+#define VIDREVOLT_METADATACACHE_H_
+
+// STL
+#include <optional>
+#include <string>
+#include <vector>
+
+// Ours
+#include "decode/Backend.h"
+
+namespace vidrevolt {
+    // Remembers what probing a video found so later launches can skip it.
+    // Entries are written under ~/.cache/vidrevolt, or to a sidecar next to
+    // the video (<video>.vrmeta) when there is no home directory or writing
+    // there fails. Loading tries the same places in the same order, so a
+    // sidecar is read when the home directory has no valid entry. Entries
+    // are only trusted while the video's size and modification time are
+    // unchanged.
+    // They are written to a temporary file and renamed into place, so a
+    // reader never sees half an entry.
+    class MetadataCache {
+        public:
+            struct Entry {
+                decode::Metadata metadata;
+                std::vector<int> keyframes;
+            };
+
+            static std::optional<Entry> load(const std::string& path);
+            static void store(const std::string& path, const Entry& entry);
+
+        private:
+            MetadataCache();
+
+            static std::vector<std::string> candidatePaths(const std::string& path);
+    };
+}
+
+#endif
@@ -1,6 +1,8 @@
 #include "Pipeline.h"
 
 // STL
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 // Ours
@@ -8,6 +10,9 @@
 #include "KeyboardManager.h"
 #include "osc/Server.h"
 #include "gl/ParamSet.h"
+#include "FrameBudget.h"
+#include "FrameCache.h"
+#include "ProxyTranscoder.h"
 
 namespace vidrevolt {
     Pipeline::Pipeline() : rand_gen_(rand_dev_()) {}
@@ -16,8 +21,16 @@ namespace vidrevolt {
         resolution_ = resolution;
         renderer_->setResolution(resolution_);
 
+        // Lazily opened videos that haven't been prefetched load as they
+        // are first rendered
         for (auto& vid_kv : videos_) {
-            vid_kv.second->waitForLoaded();
+            if (vid_kv.second->isStarted()) {
+                vid_kv.second->waitForLoaded();
+            }
+        }
+
+        for (auto& kv : playlists_) {
+            kv.second->waitForLoaded();
         }
     }
 
@@ -66,15 +79,28 @@ namespace vidrevolt {
         return id;
     }
 
-    Pipeline::ObjID Pipeline::addVideo(const std::string& path, bool auto_reset, Video::Playback pb) {
+    Pipeline::ObjID Pipeline::addVideo(const std::string& path, bool auto_reset, Video::Playback pb, const Video::Options& opts) {
         ObjID id = next_id(path);
-        auto vid =  std::make_unique<Video>(path, auto_reset, pb);
-        vid->start();
+        auto vid =  std::make_unique<Video>(path, auto_reset, pb, opts);
+        if (lazy_open_) {
+            vid->describe();
+        } else {
+            vid->start();
+        }
         setVideo(id, std::move(vid));
 
         return id;
     }
 
+    Pipeline::ObjID Pipeline::addPlaylist(const std::vector<std::string>& paths, const Video::Options& opts, bool loop) {
+        ObjID id = next_id("playlist");
+        auto playlist = std::make_unique<Playlist>(paths, opts, loop);
+        playlist->start();
+        playlists_[id] = std::move(playlist);
+
+        return id;
+    }
+
     Pipeline::ObjID Pipeline::addWebcam(int device) {
         ObjID id = next_id("webcam(" + std::to_string(device) + ")");
         auto vid =  std::make_unique<Webcam>(device);
@@ -122,15 +148,34 @@ namespace vidrevolt {
             in_use_[addr] = true;
             FrameSource* source = nullptr;
             if (videos_.count(addr) > 0) {
-                source = videos_.at(addr).get();
+                Video* vid = videos_.at(addr).get();
+                if (!vid->isStarted()) {
+                    // Starting spawns threads, so leave it to render()
+                    pending_starts_.insert(addr);
+                }
+
+                // Black at the clip's size until its initial fill lands
+                if (!vid->isLoaded()) {
+                    renderer_->placeholder(addr, vid->getResolution());
+                    continue;
+                }
+
+                source = vid;
+            } else if (playlists_.count(addr) > 0) {
+                source = playlists_.at(addr).get();
             } else if (webcams_.count(addr) > 0) {
                 source = webcams_.at(addr).get();
             }
 
-            if (source != nullptr) {
+            if (source != nullptr && source->isBlending()) {
+                auto blend_opt = source->nextBlend();
+                if (blend_opt) {
+                    renderer_->render(addr, blend_opt.value(), source->getPixelFormat());
+                }
+            } else if (source != nullptr) {
                 auto frame_opt = source->nextFrame();
                 if (frame_opt) {
-                    renderer_->render(addr, frame_opt.value());
+                    renderer_->render(addr, frame_opt.value(), source->getPixelFormat());
                 }
             }
         }
@@ -147,6 +192,68 @@ namespace vidrevolt {
         videos_.at(id)->setFPS(fps);
     }
 
+    void Pipeline::setFrameBudget(int mb) {
+        if (mb < 0) {
+            throw std::runtime_error("Frame budget must be zero (unlimited) or more megabytes");
+        }
+
+        FrameBudget::getInstance().setLimit(static_cast<size_t>(mb) * 1024 * 1024);
+    }
+
+    void Pipeline::seek(const std::string& id, double pos, bool frames) {
+        if (!videos_.count(id)) {
+            throw std::runtime_error("Attempt to seek non-existent video");
+        }
+
+        auto& vid = videos_.at(id);
+        int frame = static_cast<int>(std::lround(frames ? pos : pos * vid->getNativeFPS()));
+        vid->requestSeek(frame);
+    }
+
+    void Pipeline::scrub(const std::string& id, double amount) {
+        if (!videos_.count(id)) {
+            throw std::runtime_error("Attempt to scrub non-existent video");
+        }
+
+        auto& vid = videos_.at(id);
+        amount = std::clamp(amount, 0.0, 1.0);
+        vid->requestSeek(static_cast<int>(std::lround(amount * vid->getLastFrame())), true);
+    }
+
+    void Pipeline::cue(const std::string& id, const std::string& name) {
+        if (!videos_.count(id)) {
+            throw std::runtime_error("Attempt to cue non-existent video");
+        }
+
+        videos_.at(id)->cue(name);
+    }
+
+    void Pipeline::setFrameCache(int mb) {
+        if (mb < 0) {
+            throw std::runtime_error("Frame cache must be zero (disabled) or more megabytes");
+        }
+
+        FrameCache::getInstance().setLimit(static_cast<size_t>(mb) * 1024 * 1024);
+    }
+
+    void Pipeline::setProxies(bool enabled, int height) {
+        auto& proxies = ProxyTranscoder::getInstance();
+        proxies.setHeight(height);
+        proxies.setEnabled(enabled);
+    }
+
+    void Pipeline::setLazyOpen(bool enabled) {
+        lazy_open_ = enabled;
+    }
+
+    void Pipeline::prefetch(const std::string& id) {
+        if (!videos_.count(id)) {
+            throw std::runtime_error("Attempt to prefetch non-existent video");
+        }
+
+        videos_.at(id)->start();
+    }
+
     void Pipeline::flipPlayback(const std::string& id) {
         if (!videos_.count(id)) {
             throw std::runtime_error("Attempt to flip non-existent video");
@@ -159,6 +266,32 @@ namespace vidrevolt {
        return controllers_;
     }
 
+    std::map<Pipeline::ObjID, Video::Stats> Pipeline::getVideoStats() const {
+        std::map<ObjID, Video::Stats> stats;
+        for (const auto& kv : videos_) {
+            stats[kv.first.str()] = kv.second->getStats();
+        }
+
+        return stats;
+    }
+
+    Video::Stats Pipeline::getVideoStats(const std::string& id) const {
+        if (!videos_.count(id)) {
+            throw std::runtime_error("Stats requested for non-existent video");
+        }
+
+        return videos_.at(id)->getStats();
+    }
+
+    std::map<Pipeline::ObjID, Playlist::Stats> Pipeline::getPlaylistStats() const {
+        std::map<ObjID, Playlist::Stats> stats;
+        for (const auto& kv : playlists_) {
+            stats[kv.first.str()] = kv.second->getStats();
+        }
+
+        return stats;
+    }
+
     RenderResult Pipeline::render(std::function<void()> f) {
         last_in_use_ = in_use_;
         in_use_.clear();
@@ -167,11 +300,28 @@ namespace vidrevolt {
             kv.second->poll();
         }
 
+        for (const auto& addr : pending_starts_) {
+            videos_.at(addr)->start();
+        }
+        pending_starts_.clear();
+
         render_steps_.clear();
 
         // Perform render
         f();
 
+        // Smoothed rate we're rendering at, so videos playing faster than
+        // that can skip the frames that would never be shown.
+        auto now = std::chrono::high_resolution_clock::now();
+        if (last_render_) {
+            std::chrono::duration<double> elapsed = now - last_render_.value();
+            if (elapsed.count() > 0) {
+                double fps = 1 / elapsed.count();
+                render_fps_ = render_fps_ > 0 ? render_fps_ + (fps - render_fps_) * 0.1 : fps;
+            }
+        }
+        last_render_ = now;
+
         // Trigger out/in focus
         for (const auto& kv : videos_) {
             const auto& addr = kv.first;
@@ -179,6 +329,8 @@ namespace vidrevolt {
             bool was_in_use = last_in_use_.count(addr) > 0 ? last_in_use_.at(addr) : false;
             bool is_in_use = in_use_.count(addr) > 0 ? in_use_.at(addr) : false;
 
+            vid->setRenderFPS(render_fps_);
+
             if (was_in_use && !is_in_use) {
                 vid->outFocus();
             } else if (!was_in_use && is_in_use) {
@@ -186,6 +338,21 @@ namespace vidrevolt {
             }
         }
 
+        for (const auto& kv : playlists_) {
+            const auto& addr = kv.first;
+            auto& playlist = kv.second;
+            bool was_in_use = last_in_use_.count(addr) > 0 ? last_in_use_.at(addr) : false;
+            bool is_in_use = in_use_.count(addr) > 0 ? in_use_.at(addr) : false;
+
+            playlist->setRenderFPS(render_fps_);
+
+            if (was_in_use && !is_in_use) {
+                playlist->outFocus();
+            } else if (!was_in_use && is_in_use) {
+                playlist->inFocus();
+            }
+        }
+
         RenderResult res;
         res.primary = renderer_->getLast();
         res.aux = renderer_->getLastAux();
@@ -2,14 +2,18 @@
 #define VIDREVOLT_PATCH_H_
 
 // STL
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <random>
+#include <set>
 
 // SFML
 #include <SFML/Audio.hpp>
 
 // Ours
 #include "Video.h"
+#include "Playlist.h"
 #include "Webcam.h"
 #include "Image.h"
 #include "Controller.h"
@@ -39,7 +43,8 @@ namespace vidrevolt {
             RenderResult render(std::function<void()> f);
             void reconnectControllers();
 
-            ObjID addVideo(const std::string& path, bool auto_reset, Video::Playback pb);
+            ObjID addVideo(const std::string& path, bool auto_reset, Video::Playback pb, const Video::Options& opts);
+            ObjID addPlaylist(const std::vector<std::string>& paths, const Video::Options& opts, bool loop);
             ObjID addWebcam(int device);
             ObjID addKeyboard();
             ObjID addImage(const std::string& path);
@@ -51,13 +56,37 @@ namespace vidrevolt {
             void restartAudio();
 
             void setFPS(const std::string& id, double fps);
+            void setFrameBudget(int mb);
+            void setFrameCache(int mb);
+            // Build intra-only proxies of long-GOP videos, height 0 keeps theirs
+            void setProxies(bool enabled, int height=0);
+
+            // Only read the metadata of videos added from now on, leaving
+            // the decoder and buffer until a render step uses them or
+            // prefetch() asks for them. Cue frames are pinned straight away
+            // all the same, see Video::describe().
+            void setLazyOpen(bool enabled);
+            void prefetch(const std::string& id);
             void flipPlayback(const std::string& id);
+
+            // Jump to a position in seconds, or in frames if frames is set
+            void seek(const std::string& id, double pos, bool frames);
+
+            // Hold the video at amount (0 to 1) of the way through it
+            void scrub(const std::string& id, double amount);
+
+            // Jump to one of the video's named cues
+            void cue(const std::string& id, const std::string& name);
             void tap(const std::string& sync_id);
 
             void addRenderStep(const std::string& target, const std::string& path, gl::ParamSet params, std::vector<Address> video_deps);
 
             std::map<std::string, std::shared_ptr<Controller>> getControllers() const;
 
+            std::map<ObjID, Video::Stats> getVideoStats() const;
+            Video::Stats getVideoStats(const std::string& id) const;
+            std::map<ObjID, Playlist::Stats> getPlaylistStats() const;
+
             float rand();
 
         private:
@@ -70,6 +99,7 @@ namespace vidrevolt {
 
             std::map<std::string, std::shared_ptr<BPMSync>> bpm_syncs_;
             std::map<Address, std::unique_ptr<Video>> videos_;
+            std::map<Address, std::unique_ptr<Playlist>> playlists_;
             std::map<Address, std::unique_ptr<Webcam>> webcams_;
             std::map<std::string, std::shared_ptr<Controller>> controllers_;
             Resolution resolution_;
@@ -81,6 +111,14 @@ namespace vidrevolt {
             size_t obj_id_cursor_ = 0;
 
             std::vector<RenderStep> render_steps_;
+
+            std::optional<std::chrono::high_resolution_clock::time_point> last_render_;
+            double render_fps_ = 0;
+            bool lazy_open_ = false;
+
+            // Lazily opened videos a render step asked for, started by
+            // the next render() before any steps run
+            std::set<Address> pending_starts_;
             sf::Music music_;
 
             std::random_device rand_dev_;
@@ -0,0 +1,59 @@
+#include "PlaybackClock.h"
+
+// STL
+#include <algorithm>
+
+namespace vidrevolt {
+    void PlaybackClock::reset() {
+        last_tick_.reset();
+        owed_ms_ = 0;
+    }
+
+    bool PlaybackClock::tick(double rate) {
+        auto now = Clock::now();
+        rate_ = rate;
+
+        if (!last_tick_) {
+            last_tick_ = now;
+            return false;
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = now - last_tick_.value();
+        owed_ms_ += elapsed.count() * rate_;
+        last_tick_ = now;
+
+        return true;
+    }
+
+    bool PlaybackClock::consume(double duration_ms) {
+        if (owed_ms_ < duration_ms) {
+            return false;
+        }
+
+        owed_ms_ -= duration_ms;
+
+        return true;
+    }
+
+    void PlaybackClock::stall(double duration_ms) {
+        owed_ms_ = std::min(owed_ms_, duration_ms);
+    }
+
+    void PlaybackClock::shown(int steps) {
+        double late_ms = rate_ > 0 ? owed_ms_ / rate_ : 0;
+
+        stats_.frames++;
+        stats_.dropped += static_cast<size_t>(std::max(0, steps - 1));
+        stats_.jitter_last_ms = late_ms;
+        stats_.jitter_max_ms = std::max(stats_.jitter_max_ms, late_ms);
+        stats_.jitter_avg_ms += (late_ms - stats_.jitter_avg_ms) / static_cast<double>(stats_.frames);
+    }
+
+    double PlaybackClock::getOwed() const {
+        return owed_ms_;
+    }
+
+    PlaybackClock::Stats PlaybackClock::getStats() const {
+        return stats_;
+    }
+}
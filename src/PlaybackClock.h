@@ -0,0 +1,59 @@
+#ifndef VIDREVOLT_PLAYBACKCLOCK_H_
+#define VIDREVOLT_PLAYBACKCLOCK_H_
+
+// STL
+#include <chrono>
+#include <optional>
+
+namespace vidrevolt {
+    // Maps wall time onto a clip's media time. Each tick adds the media time
+    // that has passed since the last one, and the player spends it by
+    // stepping over frames according to their timestamps. Whatever is left
+    // over carries to the next tick, so render loop hiccups skip frames
+    // instead of slowing the clip down, and variable frame rates play at
+    // their own pace.
+    class PlaybackClock {
+        public:
+            using Clock = std::chrono::high_resolution_clock;
+
+            struct Stats {
+                size_t frames = 0;
+                size_t dropped = 0;
+                double jitter_last_ms = 0;
+                double jitter_avg_ms = 0;
+                double jitter_max_ms = 0;
+            };
+
+            // Stop counting until the next tick, which starts afresh.
+            void reset();
+
+            // Add the media time since the last tick at the given rate (media
+            // ms per wall ms). False if the clock was not running before.
+            bool tick(double rate);
+
+            // Spend duration_ms of media time if that much is owed.
+            bool consume(double duration_ms);
+
+            // Nothing more can be shown yet, so owing more than duration_ms
+            // would only make us skip ahead once frames are available again.
+            void stall(double duration_ms);
+
+            // A new frame is on screen after stepping over the given number
+            // of frames. What is still owed is how late it is.
+            void shown(int steps);
+
+            // Media time owed towards the frame after the one on screen
+            double getOwed() const;
+
+            Stats getStats() const;
+
+        private:
+            std::optional<Clock::time_point> last_tick_;
+            double rate_ = 1;
+            double owed_ms_ = 0;
+
+            Stats stats_;
+    };
+}
+
+#endif
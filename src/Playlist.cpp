@@ -0,0 +1,220 @@
+#include "Playlist.h"
+
+// STL
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace vidrevolt {
+    Playlist::Playlist(const std::vector<std::string>& paths, const Video::Options& opts, bool loop) :
+        paths_(paths), options_(opts), loop_(loop) {
+
+        if (paths_.empty()) {
+            throw std::runtime_error("Playlist needs at least one clip");
+        }
+    }
+
+    std::unique_ptr<Video> Playlist::open(const std::string& path, const Video::Options& opts) {
+        auto vid = std::make_unique<Video>(path, false, Video::Once, opts);
+        vid->start();
+
+        return vid;
+    }
+
+    void Playlist::start() {
+        current_ = open(paths_.at(0), options_);
+        preroll();
+    }
+
+    void Playlist::waitForLoaded() {
+        current_->waitForLoaded();
+    }
+
+    std::optional<size_t> Playlist::following() const {
+        if (index_ + 1 < paths_.size()) {
+            return index_ + 1;
+        }
+
+        if (loop_) {
+            return 0;
+        }
+
+        return {};
+    }
+
+    void Playlist::preroll() {
+        next_index_ = following();
+        next_ready_at_.reset();
+        if (!next_index_) {
+            return;
+        }
+
+        // Opening may probe the file, keep that off the render thread
+        opening_ = std::async(std::launch::async, &Playlist::open,
+                paths_.at(next_index_.value()), options_);
+    }
+
+    void Playlist::pollPreroll() {
+        if (next_ == nullptr && opening_.valid() &&
+                opening_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            try {
+                next_ = opening_.get();
+                next_->setRenderFPS(render_fps_);
+                if (in_focus_) {
+                    next_->inFocus();
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "WARNING: Unable to open playlist clip " <<
+                    paths_.at(next_index_.value()) << ": " << e.what() << std::endl;
+            }
+        }
+
+        // Failed while buffering, cut() moves on to the one after
+        if (next_ != nullptr && next_->isFailed()) {
+            retire(std::move(next_));
+        }
+
+        retiring_.erase(std::remove_if(retiring_.begin(), retiring_.end(), [](const std::future<void>& f) {
+            return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), retiring_.end());
+
+        if (next_ != nullptr && !next_ready_at_ && next_->isLoaded()) {
+            next_ready_at_ = Clock::now();
+        }
+    }
+
+    std::optional<cv::Mat> Playlist::nextFrame() {
+        pollPreroll();
+
+        std::optional<cv::Mat> frame = current_->nextFrame();
+        if (frame || !current_->isFinished()) {
+            return frame;
+        }
+
+        if (!cut()) {
+            return {};
+        }
+
+        return current_->nextFrame();
+    }
+
+    bool Playlist::isBlending() const {
+        return options_.blend;
+    }
+
+    std::optional<FrameSource::Blend> Playlist::nextBlend() {
+        pollPreroll();
+
+        std::optional<Blend> blend = current_->nextBlend();
+        if (blend || !current_->isFinished()) {
+            return blend;
+        }
+
+        if (!cut()) {
+            return {};
+        }
+
+        return current_->nextBlend();
+    }
+
+    bool Playlist::cut() {
+        if (!next_index_) {
+            return false;
+        }
+
+        if (!cut_due_at_) {
+            cut_due_at_ = Clock::now();
+        }
+
+        // Couldn't be opened, move on to the one after
+        if (next_ == nullptr && !opening_.valid()) {
+            index_ = next_index_.value();
+            cut_due_at_.reset();
+            preroll();
+            return false;
+        }
+
+        // Hold the last frame until the next clip has some to show
+        if (!next_ready_at_) {
+            return false;
+        }
+
+        std::chrono::duration<double, std::milli> lead = cut_due_at_.value() - next_ready_at_.value();
+        recordCut(lead.count());
+        cut_due_at_.reset();
+
+        std::cerr << "Playlist cut to " << paths_.at(next_index_.value());
+        if (lead.count() < 0) {
+            std::cerr << ", stalled " << -lead.count() << "ms for its first frames" << std::endl;
+        } else {
+            std::cerr << ", ready " << lead.count() << "ms before" << std::endl;
+        }
+
+        if (in_focus_) {
+            current_->outFocus();
+        }
+
+        retire(std::move(current_));
+        current_ = std::move(next_);
+        index_ = next_index_.value();
+        preroll();
+
+        return true;
+    }
+
+    void Playlist::retire(std::unique_ptr<Video> vid) {
+        retiring_.push_back(std::async(std::launch::async, [vid = std::move(vid)]() mutable {
+            vid.reset();
+        }));
+    }
+
+    void Playlist::recordCut(double lead_ms) {
+        stats_.cuts++;
+        if (lead_ms < 0) {
+            stats_.stalls++;
+        }
+
+        stats_.preroll_last_ms = lead_ms;
+        stats_.preroll_min_ms = stats_.cuts == 1 ? lead_ms : std::min(stats_.preroll_min_ms, lead_ms);
+        stats_.preroll_avg_ms += (lead_ms - stats_.preroll_avg_ms) / static_cast<double>(stats_.cuts);
+    }
+
+    FrameSource::PixelFormat Playlist::getPixelFormat() const {
+        return options_.pixel_format;
+    }
+
+    void Playlist::inFocus() {
+        in_focus_ = true;
+        current_->inFocus();
+
+        // Keeps the prerolled buffer from being evicted
+        if (next_ != nullptr) {
+            next_->inFocus();
+        }
+    }
+
+    void Playlist::outFocus() {
+        in_focus_ = false;
+        current_->outFocus();
+
+        if (next_ != nullptr) {
+            next_->outFocus();
+        }
+    }
+
+    void Playlist::setRenderFPS(double fps) {
+        render_fps_ = fps;
+        current_->setRenderFPS(fps);
+
+        if (next_ != nullptr) {
+            next_->setRenderFPS(fps);
+        }
+    }
+
+    Playlist::Stats Playlist::getStats() const {
+        Stats stats = stats_;
+        stats.clip = index_;
+
+        return stats;
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef VIDREVOLT_PLAYLIST_H_
+#define VIDREVOLT_PLAYLIST_H_
+
+// STL
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "FrameSource.h"
+#include "Video.h"
+
+namespace vidrevolt {
+    // Plays clips back to back. While one plays, the next is opened and
+    // its buffer filled in the background, so the cut to it shows its
+    // first frame on the first render after the last frame of the clip
+    // before has run its duration. Only the playing clip and the next are
+    // open at a time, clips cut away from are stopped in the background.
+    class Playlist : public FrameSource {
+        public:
+            using Clock = std::chrono::high_resolution_clock;
+
+            struct Stats {
+                size_t clip = 0;
+                size_t cuts = 0;
+
+                // Cuts the next clip wasn't buffered for
+                size_t stalls = 0;
+
+                // How long before each cut the next clip was ready,
+                // negative for how long a stall lasted
+                double preroll_last_ms = 0;
+                double preroll_min_ms = 0;
+                double preroll_avg_ms = 0;
+            };
+
+            Playlist(const std::vector<std::string>& paths, const Video::Options& opts, bool loop);
+
+            void start();
+            void waitForLoaded();
+
+            std::optional<cv::Mat> nextFrame() override;
+            bool isBlending() const override;
+            std::optional<Blend> nextBlend() override;
+            PixelFormat getPixelFormat() const override;
+
+            void inFocus();
+            void outFocus();
+            void setRenderFPS(double fps);
+
+            Stats getStats() const;
+
+        private:
+            static std::unique_ptr<Video> open(const std::string& path, const Video::Options& opts);
+
+            // Index of the clip after index_, if there is one
+            std::optional<size_t> following() const;
+
+            // Start opening the clip after the current one
+            void preroll();
+
+            // Pick up the prerolled clip once it's open and note when it
+            // has frames to show.
+            void pollPreroll();
+
+            // Switch to the next clip, false if there isn't one or it
+            // isn't ready yet
+            bool cut();
+
+            // Negative when the cut had to wait for the next clip
+            void recordCut(double lead_ms);
+
+            // Stopping a clip joins its threads, so that happens in the
+            // background instead of on the render thread
+            void retire(std::unique_ptr<Video> vid);
+
+            const std::vector<std::string> paths_;
+            const Video::Options options_;
+            const bool loop_;
+
+            size_t index_ = 0;
+            std::unique_ptr<Video> current_;
+
+            std::future<std::unique_ptr<Video>> opening_;
+            std::unique_ptr<Video> next_;
+            std::optional<size_t> next_index_;
+            std::optional<Clock::time_point> next_ready_at_;
+            std::optional<Clock::time_point> cut_due_at_;
+
+            // Clips being stopped, see retire()
+            std::vector<std::future<void>> retiring_;
+
+            bool in_focus_ = false;
+            double render_fps_ = 0;
+
+            Stats stats_;
+    };
+}
+
+#endif
@@ -0,0 +1,291 @@
+#include "ProxyTranscoder.h"
+
+// STL
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+// Boost
+#include <boost/filesystem.hpp>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "decode/Backend.h"
+
+#define PROXY_EXT ".avi"
+#define PROXY_QUALITY 95
+
+namespace fs = boost::filesystem;
+
+namespace vidrevolt {
+    ProxyTranscoder& ProxyTranscoder::getInstance() {
+        static ProxyTranscoder transcoder;
+        return transcoder;
+    }
+
+    ProxyTranscoder::~ProxyTranscoder() {
+        stopping_ = true;
+        work_cv_.notify_all();
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void ProxyTranscoder::setEnabled(bool enabled) {
+        enabled_ = enabled;
+    }
+
+    bool ProxyTranscoder::isEnabled() const {
+        return enabled_.load();
+    }
+
+    void ProxyTranscoder::setHeight(int height) {
+        if (height < 0) {
+            throw std::runtime_error("Proxy height must be zero (source resolution) or more pixels");
+        }
+
+        height_ = height;
+    }
+
+    void ProxyTranscoder::setCacheDir(const std::string& dir) {
+        std::lock_guard guard(mutex_);
+        cache_dir_ = dir;
+    }
+
+    bool ProxyTranscoder::isLongGOP(const std::vector<int>& keyframes, int frame_count) {
+        if (keyframes.empty()) {
+            return false;
+        }
+
+        return frame_count / static_cast<int>(keyframes.size()) > VIDREVOLT_PROXY_MIN_GOP;
+    }
+
+    std::optional<std::string> ProxyTranscoder::proxyPath(const std::string& path) const {
+        boost::system::error_code ec;
+        auto size = fs::file_size(path, ec);
+        if (ec) {
+            return {};
+        }
+
+        auto mtime = fs::last_write_time(path, ec);
+        if (ec) {
+            return {};
+        }
+
+        fs::path dir;
+        {
+            std::lock_guard guard(mutex_);
+            dir = cache_dir_;
+        }
+
+        if (dir.empty()) {
+            const char* home = std::getenv("HOME");
+            if (home == nullptr) {
+                return {};
+            }
+
+            dir = fs::path(home) / ".cache" / "vidrevolt" / "proxies";
+        }
+
+        // A changed source or height makes for a different proxy
+        std::ostringstream name;
+        name << fs::path(path).stem().string() << "-" << std::hex <<
+            std::hash<std::string>{}(fs::absolute(path).string()) << "-" << size << "-" << mtime <<
+            std::dec << "-" << height_.load() << PROXY_EXT;
+
+        return (dir / name.str()).string();
+    }
+
+    void ProxyTranscoder::request(const std::string& path) {
+        if (!isEnabled() || find(path)) {
+            return;
+        }
+
+        std::lock_guard guard(mutex_);
+        if (requested_[path]) {
+            return;
+        }
+
+        requested_[path] = true;
+        queue_.push_back(path);
+        stats_.queued++;
+
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&ProxyTranscoder::loop, this);
+        }
+
+        work_cv_.notify_one();
+    }
+
+    std::optional<std::string> ProxyTranscoder::find(const std::string& path) {
+        {
+            std::lock_guard guard(mutex_);
+            if (ready_.count(path) > 0) {
+                return ready_.at(path);
+            }
+
+            // Still in the works
+            if (requested_.count(path) > 0) {
+                return {};
+            }
+        }
+
+        // Built on an earlier run?
+        std::optional<std::string> proxy = proxyPath(path);
+        boost::system::error_code ec;
+        if (!proxy || !fs::exists(proxy.value(), ec)) {
+            return {};
+        }
+
+        std::lock_guard guard(mutex_);
+        ready_[path] = proxy.value();
+
+        return proxy;
+    }
+
+    void ProxyTranscoder::loop() {
+        while (!stopping_.load()) {
+            std::string path;
+            {
+                std::unique_lock<std::mutex> lk(mutex_);
+                work_cv_.wait(lk, [this]{ return !queue_.empty() || stopping_.load(); });
+                if (stopping_.load()) {
+                    return;
+                }
+
+                path = queue_.front();
+                queue_.pop_front();
+                stats_.current = path;
+            }
+
+            progress_ = 0;
+
+            std::optional<std::string> proxy = proxyPath(path);
+            bool ok = proxy && transcode(path, proxy.value());
+
+            std::lock_guard guard(mutex_);
+            stats_.queued--;
+            stats_.current.clear();
+            if (ok) {
+                stats_.built++;
+                ready_[path] = proxy.value();
+            } else if (!stopping_.load()) {
+                stats_.failed++;
+                std::cerr << "WARNING: Unable to build a proxy for " << path << std::endl;
+            }
+        }
+    }
+
+    bool ProxyTranscoder::transcode(const std::string& path, const std::string& proxy) {
+        // Written under a temporary name so a proxy that exists is complete.
+        // It keeps the extension VideoWriter picks the container by.
+        std::string partial = (fs::path(proxy).parent_path() /
+                (fs::path(proxy).stem().string() + ".part" + PROXY_EXT)).string();
+
+        try {
+            boost::system::error_code ec;
+            fs::create_directories(fs::path(proxy).parent_path(), ec);
+
+            auto backend = decode::Backend::create(decode::Backend::LibAV, path);
+            auto md = backend->probe();
+
+            int height = height_.load();
+            cv::Size size(md.resolution.width, md.resolution.height);
+            if (height > 0 && height < size.height) {
+                // Keep the aspect ratio, MJPEG wants even dimensions
+                size.width = static_cast<int>(std::lround(
+                            static_cast<double>(size.width) * height / size.height)) / 2 * 2;
+                size.height = height / 2 * 2;
+            }
+
+            cv::VideoWriter writer(partial, cv::VideoWriter::fourcc('M','J','P','G'), md.fps, size);
+            if (!writer.isOpened()) {
+                return false;
+            }
+            writer.set(cv::VIDEOWRITER_PROP_QUALITY, PROXY_QUALITY);
+
+            decode::Frame frame;
+            int frames = 0;
+            cv::Mat out;
+            while (!stopping_.load() && backend->read(frame)) {
+                if (frame.mat.size() != size) {
+                    cv::resize(frame.mat, out, size, 0, 0, cv::INTER_AREA);
+                } else {
+                    out = frame.mat;
+                }
+                writer.write(out);
+
+                frames++;
+                if (md.frame_count > 0) {
+                    progress_ = static_cast<double>(frames) / md.frame_count;
+                }
+            }
+
+            writer.release();
+
+            if (stopping_.load() || frames == 0) {
+                fs::remove(partial, ec);
+                return false;
+            }
+
+            fs::rename(partial, proxy);
+        } catch (const std::exception& e) {
+            std::cerr << "WARNING: Proxy transcode of " << path << " failed: " << e.what() << std::endl;
+
+            boost::system::error_code ec;
+            fs::remove(partial, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    ProxyTranscoder::Stats ProxyTranscoder::getStats() const {
+        Stats stats;
+        fs::path dir;
+        {
+            std::lock_guard guard(mutex_);
+            stats = stats_;
+            dir = cache_dir_;
+        }
+
+        stats.progress = stats.current.empty() ? 0 : progress_.load();
+
+        if (dir.empty()) {
+            const char* home = std::getenv("HOME");
+            if (home != nullptr) {
+                dir = fs::path(home) / ".cache" / "vidrevolt" / "proxies";
+            }
+        }
+
+        boost::system::error_code ec;
+        if (!dir.empty() && fs::is_directory(dir, ec)) {
+            for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+                if (fs::is_regular_file(it->path(), ec)) {
+                    stats.disk_bytes += fs::file_size(it->path(), ec);
+                }
+            }
+        }
+
+        return stats;
+    }
+
+    std::string ProxyTranscoder::str() const {
+        Stats stats = getStats();
+
+        std::ostringstream out;
+        out << "proxies: queued=" << stats.queued << " built=" << stats.built <<
+            " failed=" << stats.failed << " disk=" << stats.disk_bytes / (1024 * 1024) << "MB";
+        if (!stats.current.empty()) {
+            out << " building " << stats.current << " " << static_cast<int>(stats.progress * 100) << "%";
+        }
+        out << std::endl;
+
+        return out.str();
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef VIDREVOLT_PROXYTRANSCODER_H_
+#define VIDREVOLT_PROXYTRANSCODER_H_
+
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Average keyframe spacing, in frames, above which a proxy pays off. Up to
+// about two seconds at 30fps, a seek decodes few enough frames that the
+// buffer hides it. Longer GOPs, like streaming encodes with 250 frames
+// between keyframes, make every reverse refill decode far more than it
+// keeps. Below that, the transcode time and disk space aren't worth it.
+#define VIDREVOLT_PROXY_MIN_GOP 60
+
+namespace vidrevolt {
+    // Builds intra-only (MJPEG) proxies of long-GOP videos in the
+    // background, one at a time, so seeking and reverse playback stop
+    // paying for a decode from the previous keyframe. This is what
+    // make-choppable in snippets.md does by hand. Proxies are kept in a
+    // cache directory, named after the source's path, size and mtime, and
+    // reused on later runs.
+    class ProxyTranscoder {
+        public:
+            struct Stats {
+                size_t queued = 0;
+                size_t built = 0;
+                size_t failed = 0;
+                std::string current;
+                double progress = 0;
+                size_t disk_bytes = 0;
+            };
+
+            static ProxyTranscoder& getInstance();
+            ~ProxyTranscoder();
+
+            // Off by default. Height of zero keeps the source's resolution.
+            void setEnabled(bool enabled);
+            bool isEnabled() const;
+            void setHeight(int height);
+            void setCacheDir(const std::string& dir);
+
+            static bool isLongGOP(const std::vector<int>& keyframes, int frame_count);
+
+            // Queue a proxy of path unless there is one already.
+            void request(const std::string& path);
+
+            // Path of the finished proxy for path, if there is one.
+            std::optional<std::string> find(const std::string& path);
+
+            Stats getStats() const;
+            std::string str() const;
+
+        private:
+            ProxyTranscoder() = default;
+
+            void loop();
+            bool transcode(const std::string& path, const std::string& proxy);
+            std::optional<std::string> proxyPath(const std::string& path) const;
+
+            std::atomic<bool> enabled_ = false;
+            std::atomic<int> height_ = 0;
+
+            mutable std::mutex mutex_;
+            std::condition_variable work_cv_;
+            std::string cache_dir_;
+            std::deque<std::string> queue_;
+            std::map<std::string, std::string> ready_;
+            std::map<std::string, bool> requested_;
+            Stats stats_;
+            std::atomic<double> progress_ = 0;
+
+            std::thread thread_;
+            std::atomic<bool> stopping_ = false;
+    };
+}
+
+#endif
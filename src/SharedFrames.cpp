@@ -0,0 +1,149 @@
+#include "SharedFrames.h"
+
+// STL
+#include <algorithm>
+#include <sstream>
+
+// Ours
+#include "decode/Backend.h"
+
+namespace vidrevolt {
+    std::mutex SharedFrames::registry_mutex_;
+    std::map<std::string, std::weak_ptr<SharedFrames>> SharedFrames::registry_;
+
+    std::shared_ptr<SharedFrames> SharedFrames::acquire(const std::string& key) {
+        std::lock_guard guard(registry_mutex_);
+
+        std::shared_ptr<SharedFrames> frames;
+        if (registry_.count(key) > 0) {
+            frames = registry_.at(key).lock();
+        }
+
+        if (frames == nullptr) {
+            frames = std::make_shared<SharedFrames>();
+            registry_[key] = frames;
+        }
+
+        return frames;
+    }
+
+    SharedFrames::Stats SharedFrames::getTotals(size_t* files) {
+        Stats totals;
+        size_t live = 0;
+
+        std::lock_guard guard(registry_mutex_);
+        for (auto it = registry_.begin(); it != registry_.end();) {
+            std::shared_ptr<SharedFrames> frames = it->second.lock();
+            if (frames == nullptr) {
+                it = registry_.erase(it);
+                continue;
+            }
+
+            Stats stats = frames->getStats();
+            totals.hits += stats.hits;
+            totals.misses += stats.misses;
+            totals.frames += stats.frames;
+            live++;
+            it++;
+        }
+
+        if (files != nullptr) {
+            *files = live;
+        }
+
+        return totals;
+    }
+
+    std::string SharedFrames::str() {
+        size_t files = 0;
+        Stats totals = getTotals(&files);
+        size_t lookups = totals.hits + totals.misses;
+
+        std::ostringstream out;
+        out << "shared frames: files=" << files << " frames=" << totals.frames <<
+            " hits=" << totals.hits << " misses=" << totals.misses << " hit rate=" <<
+            (lookups > 0 ? static_cast<int>(100 * totals.hits / lookups) : 0) << "%" <<
+            " decoders=" << decode::Backend::getInstances() << std::endl;
+
+        return out.str();
+    }
+
+    void SharedFrames::reserve(size_t frames) {
+        std::lock_guard guard(mutex_);
+        capacity_ = std::max(capacity_, frames);
+    }
+
+    void SharedFrames::publish(const decode::Frame& frame, const void* owner) {
+        // Frames that don't own their pixels (views of a clip's mapping)
+        // would dangle once the publisher's backend goes. Decoding those
+        // again is only a copy out of the mapping anyway.
+        if (frame.mat.u == nullptr) {
+            return;
+        }
+
+        std::lock_guard guard(mutex_);
+
+        auto it = frames_.find(frame.pos);
+        if (it != frames_.end()) {
+            it->second = Entry{frame, owner};
+            return;
+        }
+
+        frames_[frame.pos] = Entry{frame, owner};
+        order_.push_back(frame.pos);
+
+        while (order_.size() > capacity_) {
+            frames_.erase(order_.front());
+            order_.pop_front();
+        }
+    }
+
+    std::optional<decode::Frame> SharedFrames::get(int pos) {
+        std::lock_guard guard(mutex_);
+
+        auto it = frames_.find(pos);
+        if (it == frames_.end()) {
+            stats_.misses++;
+            return {};
+        }
+
+        stats_.hits++;
+
+        return it->second.frame;
+    }
+
+    void SharedFrames::drop(const void* owner) {
+        std::lock_guard guard(mutex_);
+
+        for (auto it = frames_.begin(); it != frames_.end();) {
+            if (it->second.owner == owner) {
+                order_.erase(std::find(order_.begin(), order_.end(), it->first));
+                it = frames_.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    size_t SharedFrames::bytes(const void* owner, const std::function<bool(int)>& held) const {
+        std::lock_guard guard(mutex_);
+
+        size_t total = 0;
+        for (const auto& [pos, entry] : frames_) {
+            if (entry.owner == owner && !held(pos)) {
+                total += entry.frame.mat.total() * entry.frame.mat.elemSize();
+            }
+        }
+
+        return total;
+    }
+
+    SharedFrames::Stats SharedFrames::getStats() const {
+        std::lock_guard guard(mutex_);
+
+        Stats stats = stats_;
+        stats.frames = frames_.size();
+
+        return stats;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef VIDREVOLT_SHAREDFRAMES_H_
+#define VIDREVOLT_SHAREDFRAMES_H_
+
+// STL
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+// Ours
+#include "decode/Frame.h"
+
+namespace vidrevolt {
+    // Recently decoded frames of one file, shared by every Video playing
+    // it, e.g. a forward and a mirrored layer of the same clip. Each keeps
+    // its own cursor, direction and fps, but a refill near where another
+    // has just decoded takes those frames instead of decoding them again.
+    // The frames are reference counted cv::Mats, so sharing costs no copy.
+    // Each frame remembers which Video published it, so that Video can
+    // account for it (see FrameBudget) and drop it again on eviction.
+    class SharedFrames {
+        public:
+            struct Stats {
+                size_t hits = 0;
+                size_t misses = 0;
+                size_t frames = 0;
+            };
+
+            // The store for key, created on first use and gone with its
+            // last user.
+            static std::shared_ptr<SharedFrames> acquire(const std::string& key);
+
+            // Totals over every store, and how many there are
+            static Stats getTotals(size_t* files = nullptr);
+            static std::string str();
+
+            // Hold at least this many of the most recently decoded frames
+            void reserve(size_t frames);
+
+            void publish(const decode::Frame& frame, const void* owner);
+            std::optional<decode::Frame> get(int pos);
+
+            // Forget every frame owner published
+            void drop(const void* owner);
+
+            // Size of the frames owner published, except those held says
+            // are kept alive elsewhere anyway
+            size_t bytes(const void* owner, const std::function<bool(int)>& held) const;
+
+            Stats getStats() const;
+
+        private:
+            static std::mutex registry_mutex_;
+            static std::map<std::string, std::weak_ptr<SharedFrames>> registry_;
+
+            struct Entry {
+                decode::Frame frame;
+                const void* owner = nullptr;
+            };
+
+            mutable std::mutex mutex_;
+            std::map<int, Entry> frames_;
+
+            // Oldest first
+            std::deque<int> order_;
+            size_t capacity_ = 0;
+
+            Stats stats_;
+    };
+}
+
+#endif
@@ -2,27 +2,59 @@
 
 // STL
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
 
 // Ours
 #include "fileutil.h"
+#include "FrameBudget.h"
+#include "FrameCache.h"
+#include "FramePool.h"
+#include "MetadataCache.h"
+#include "ProxyTranscoder.h"
 
 #include "debug.h"
 #define debug_time false
 
-#define WORK_THRESHOLD 3
-
 DEBUG_TIME_DECLARE(seek)
 DEBUG_TIME_DECLARE(read_rev)
 DEBUG_TIME_DECLARE(read_single)
-DEBUG_TIME_DECLARE(frame_processing)
+DEBUG_TIME_DECLARE(refill)
+DEBUG_TIME_DECLARE(refill_lock)
+DEBUG_TIME_DECLARE(next_frame_lock)
 
 namespace vidrevolt {
     Video::Video(const std::string& path, Playback pb) : Video(path, false, pb) {}
 
     Video::Video(const std::string& path, bool auto_reset, Playback pb) :
+        Video(path, auto_reset, pb, Options()) {}
+
+    Video::Video(const std::string& path, bool auto_reset, Playback pb, const Options& opts) :
         path_(path), reverse_(pb == Reverse),
-        auto_reset_(auto_reset), playback_(pb) {}
+        auto_reset_(auto_reset), playback_(pb), options_(opts),
+        middle_(static_cast<int>(opts.buffer_depth / 2)), buffer_(opts.buffer_depth),
+        out_focus_since_(DecodeScheduler::Clock::now().time_since_epoch().count()) {
+
+        if (options_.refill_threshold < 0 ||
+                static_cast<size_t>(options_.refill_threshold) > options_.buffer_depth / 2) {
+            throw std::runtime_error("Video refill threshold must be between 0 and half the buffer depth for " + path_);
+        }
+
+        if (options_.pixel_format != BGR && options_.backend != decode::Backend::LibAV) {
+            throw std::runtime_error("Only the libav backend decodes to YUV, asked for by " + path_);
+        }
+
+        for (const auto& [name, seconds] : options_.cues) {
+            if (seconds < 0) {
+                throw std::runtime_error("Cue " + name + " is before the start of " + path_);
+            }
+        }
+    }
 
     Video::~Video() {
         stop();
@@ -33,327 +65,1615 @@ namespace vidrevolt {
     }
 
     void Video::inFocus() {
+        in_focus_ = true;
+        evict_requested_ = false;
 
+        if (evicted_.load()) {
+            signalWork();
+        }
     }
 
     void Video::outFocus() {
+        in_focus_ = false;
+        out_focus_since_ = DecodeScheduler::Clock::now().time_since_epoch().count();
         requested_reset_ = auto_reset_;
-        last_update_.reset();
+        {
+            std::lock_guard guard(buffer_mutex_);
+            clock_.reset();
+        }
         signalWork();
     }
 
     void Video::signalWork() {
-        std::lock_guard lk(work_ready_mutex_);
-        work_ready_ = true;
-        work_ready_cv_.notify_one();
+        if (running_.load() && !failed_.load()) {
+            DecodeScheduler::getInstance().schedule(this);
+        }
     }
 
-    std::optional<cv::Mat> Video::nextFrame() {
-        return nextFrame(false);
+    bool Video::isInFocus() const {
+        return in_focus_.load();
     }
 
-    std::optional<cv::Mat> Video::nextFrame(bool force) {
-        if (finished_) {
-            return {};
+    DecodeScheduler::Clock::time_point Video::getOutFocusSince() const {
+        return DecodeScheduler::Clock::time_point(
+                DecodeScheduler::Clock::duration(out_focus_since_.load()));
+    }
+
+    void Video::requestEviction() {
+        if (in_focus_.load()) {
+            return;
         }
 
-        std::chrono::high_resolution_clock::time_point now =
-            std::chrono::high_resolution_clock::now();
+        evict_requested_ = true;
+        signalWork();
+    }
+
+    bool Video::isEvictionPending() const {
+        return evict_requested_.load();
+    }
 
-        if (!force && last_update_.has_value()) {
-            std::chrono::duration<float> duration_s = now - last_update_.value();
+    size_t Video::getBufferedBytes() const {
+        return buffered_bytes_.load();
+    }
 
-            float frame_dur = 1 / static_cast<float>(fps_);
-            float past_target = duration_s.count() - frame_dur + error_;
-            if (past_target < 0) {
-                return {};
-            }
+    void Video::evict() {
+        std::lock_guard guard(buffer_mutex_);
 
-            error_ = past_target;
+        if (cursor_ >= 0 && static_cast<size_t>(cursor_) < buffer_.size()) {
+            resume_pos_ = buffer_.posAt(static_cast<size_t>(cursor_));
         }
 
-        std::lock_guard guard(buffer_mutex_);
+        buffer_.clear();
+        staged_.clear();
+        buffered_bytes_ = 0;
+        ahead_ = 0;
+        evicted_ = true;
+        evictions_++;
 
-        std::optional<Frame> frame_opt = currentFrame();
-        if (!frame_opt) {
-            return {};
+        // What we left for other Videos of the file goes too
+        if (shared_) {
+            shared_->drop(this);
         }
 
-        Frame frame = frame_opt.value();
+        // The buffers just went back to the pool, hand them to the OS so the
+        // budget actually lowers what we hold.
+        FramePool::getInstance().trim();
+    }
 
-        if (playback_ == Mirror) {
-            if (frame.first >= last_frame_.load()) {
-                reverse_ = true;
-            } else if (frame.first == 0) {
-                reverse_ = false;
-            }
+    double Video::getDeadlineMS() {
+        if (preloaded_.load()) {
+            return std::numeric_limits<double>::infinity();
         }
 
-        if (reverse_) {
-            cursor_--;
+        if (!loaded_.load() || evict_requested_.load() || seek_pending_.load()) {
+            return 0;
+        }
 
-            if (VIDREVOLT_VIDEO_MIDDLE  - cursor_ > WORK_THRESHOLD) {
-                signalWork();
+        if (!in_focus_.load()) {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        // Each buffered frame covers stride source frames of media time,
+        // which passes faster or slower than wall time as setFPS() says.
+        double rate = native_fps_.load() > 0 ? fps_.load() / native_fps_.load() : 1;
+        return std::max(0, ahead_.load()) * nominalDuration() / rate;
+    }
+
+    void Video::work() {
+        if (failed_.load()) {
+            return;
+        }
+
+        try {
+            step();
+        } catch (const std::exception& e) {
+            fail(e.what());
+        }
+    }
+
+    void Video::fail(const std::string& reason) {
+        std::cerr << "WARNING: Unable to play " << path_ << ": " << reason << std::endl;
+
+        // Nothing more gets scheduled, and whoever waits on the first
+        // frame is let go.
+        std::lock_guard guard(load_mutex_);
+        failed_ = true;
+        load_cv_.notify_all();
+    }
+
+    bool Video::isFailed() const {
+        return failed_.load();
+    }
+
+    void Video::step() {
+        // Playback comes from the arena once preloaded, the buffer is spare.
+        if (preloaded_.load()) {
+            std::lock_guard guard(buffer_mutex_);
+            if (cursor_ >= 0 && static_cast<size_t>(cursor_) < buffer_.size()) {
+                handoff_pos_ = buffer_.posAt(static_cast<size_t>(cursor_));
             }
-        } else {
-            cursor_++;
 
-            if (cursor_ - VIDREVOLT_VIDEO_MIDDLE > WORK_THRESHOLD) {
-                signalWork();
+            buffer_.clear();
+            staged_.clear();
+            buffered_bytes_ = 0;
+            ahead_ = 0;
+
+            std::lock_guard load_guard(load_mutex_);
+            if (!loaded_) {
+                cv::Size size = imageSize(arena_->at(0), options_.pixel_format);
+                res_.width = size.width;
+                res_.height = size.height;
+                loaded_ = true;
+                load_cv_.notify_all();
             }
+
+            return;
         }
 
-        last_update_ = std::chrono::high_resolution_clock::now();
+        if (evict_requested_.exchange(false)) {
+            evict();
+            return;
+        }
 
-        if (frame.first == last_frame_ && playback_ == Once) {
-            finished_ = true;
+        // Stay empty until we're back in focus
+        if (evicted_.load() && !in_focus_.load()) {
+            return;
         }
 
-        return frame.second;
-    }
+        // Switch over as soon as the proxy is done, buffered frames stay
+        if (proxy_wanted_ && !proxy_active_.load()) {
+            std::optional<std::string> proxy = ProxyTranscoder::getInstance().find(path_);
+            if (proxy) {
+                useProxy(proxy.value());
+            }
+        }
 
-    std::optional<Video::Frame> Video::currentFrame() {
-        if (cursor_ < 0 || static_cast<size_t>(cursor_) >= buffer_.size()) {
-            std::cerr << "WARNING: Video buffer exceeded! Try a a lower resolution video or increase key frames. Path:" <<
-                path_ << std::endl;
+        adapt();
+        next();
+        refills_++;
 
-            return {};
-        } else {
-            return buffer_.at(static_cast<size_t>(cursor_));
+        {
+            // Frames we published for other Videos of the file count
+            // too, unless our own buffer holds them anyway.
+            std::lock_guard guard(buffer_mutex_);
+            size_t shared = shared_->bytes(this, [this](int pos) {
+                return buffer_.find(pos).has_value() || staged_.count(pos) > 0;
+            });
+            buffered_bytes_ = buffer_.bytes() + getStagedBytes() + shared;
+        }
+        evicted_ = false;
+
+        FrameBudget::getInstance().enforce();
+
+        std::lock_guard guard(load_mutex_);
+        if (!loaded_) {
+            cv::Size size = imageSize(buffer_.front().mat, options_.pixel_format);
+            res_.width = size.width;
+            res_.height = size.height;
+            loaded_ = true;
+            load_cv_.notify_all();
         }
     }
 
-    Video::Frame Video::readFrame() {
-        DEBUG_TIME_START(read_single)
-        int pos = static_cast<int>(vid_->get(cv::CAP_PROP_POS_FRAMES));
-        cv::Mat frame;
-        if (vid_->read(frame)) {
-            // TODO: Don't modify the matrix, simply load the opengl texture differently
-            DEBUG_TIME_START(frame_processing)
-            cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
-            flip(frame, frame, 0);
-            DEBUG_TIME_END(frame_processing)
+    void Video::updateAhead() {
+        if (reverse_) {
+            ahead_ = cursor_;
         } else {
-            vid_->set(cv::CAP_PROP_POS_FRAMES, 0);
+            ahead_ = static_cast<int>(buffer_.size()) - 1 - cursor_;
+        }
+    }
+
+    Video::Stats Video::getStats() const {
+        Stats stats;
+        stats.queue_wait = getQueueWait();
+        stats.refills = refills_.load();
+        stats.in_focus = in_focus_.load();
+        stats.buffered_bytes = buffered_bytes_.load();
+        stats.evictions = evictions_.load();
+        stats.underruns = underruns_.load();
+        stats.keyframes_indexed = index_ != nullptr && index_->isReady();
+        stats.frames_decoded = frames_decoded_.load();
+        stats.frames_reused = frames_reused_.load();
+        stats.frames_cached = frames_cached_.load();
+        stats.frames_skipped = frames_skipped_.load();
+        stats.stride = stride_.load();
+        {
+            std::lock_guard guard(stats_mutex_);
+            stats.refill_last_ms = refill_last_ms_;
+            stats.refill_avg_ms = refill_avg_ms_;
+            stats.refill_max_ms = refill_max_ms_;
+            if (refill_total_ms_ > 0) {
+                stats.decode_fps = static_cast<double>(stats.frames_decoded) * 1000 / refill_total_ms_;
+            }
+        }
+        {
+            std::lock_guard guard(buffer_mutex_);
+            stats.buffer_depth = buffer_.capacity();
+            stats.buffered_frames = buffer_.size();
+            stats.frames_ahead = ahead_.load();
+            stats.playback = clock_.getStats();
+            stats.seeks = seeks_;
+            stats.seeks_buffered = seeks_buffered_;
+            stats.seek_latency_last_ms = seek_latency_last_ms_;
+            stats.seek_latency_avg_ms = seek_latency_avg_ms_;
+            stats.seek_latency_max_ms = seek_latency_max_ms_;
+            stats.cues_shown = cues_shown_;
+            stats.cue_latency_last_ms = cue_latency_last_ms_;
+            stats.cue_latency_avg_ms = cue_latency_avg_ms_;
+            stats.cue_latency_max_ms = cue_latency_max_ms_;
+        }
+        {
+            std::lock_guard guard(cue_mutex_);
+            stats.cues_pinned = cue_frames_.size();
+            for (const auto& [name, frames] : cue_frames_) {
+                for (const Frame& frame : *frames) {
+                    stats.cue_bytes += frame.mat.total() * frame.mat.elemSize();
+                }
+            }
+        }
 
-            return readFrame();
+        stats.proxy_active = proxy_active_.load();
+        stats.frames_shared = frames_shared_.load();
+        stats.started = running_.load();
+        stats.decoder_open = decoder_open_.load();
+        if (shared_ != nullptr) {
+            // Videos playing the file, us included
+            stats.shared_users = static_cast<size_t>(shared_.use_count());
         }
 
-        DEBUG_TIME_END(read_single)
+        // What each frame costs in memory and upload, against BGR
+        if (loaded_.load()) {
+            size_t pixels = static_cast<size_t>(res_.width) * static_cast<size_t>(res_.height);
+            stats.pixel_format = options_.pixel_format;
+            stats.rgb_frame_bytes = pixels * 3;
+            stats.frame_bytes = options_.pixel_format == NV12 ? pixels * 3 / 2 : pixels * 3;
+        }
+        stats.preload_progress = preload_progress_.load();
+        if (preloaded_.load()) {
+            stats.preload_bytes = arena_->bytes();
+        }
 
-        return std::make_pair(pos, frame);
+        return stats;
     }
 
-    void Video::seek(int pos) {
-        DEBUG_TIME_START(seek)
-        if (pos < 0) {
-            pos += total_frames_;
+    std::optional<cv::Mat> Video::nextFrame() {
+        return nextFrame(false);
+    }
+
+    std::optional<cv::Mat> Video::nextFrame(bool force) {
+        if (finished_ || failed_.load()) {
+            return {};
         }
 
-        pos = pos % total_frames_;
+        // Nothing has been missed before the initial fill lands
+        if (!loaded_.load()) {
+            return {};
+        }
 
-        vid_->set(cv::CAP_PROP_POS_FRAMES, pos);
-        DEBUG_TIME_END(seek)
-    }
+        if (preloaded_.load()) {
+            return nextArenaFrame(force);
+        }
 
-    double Video::getRemainingMS() {
-        return length_ms - vid_->get(cv::CAP_PROP_POS_MSEC);
-    }
+        DEBUG_TIME_START(next_frame_lock)
+        std::lock_guard guard(buffer_mutex_);
 
-    void Video::next() {
-        // At the end of the day, this is where we want the read cursor to end up.
-        int middle = VIDREVOLT_VIDEO_MIDDLE;
+        // A cue plays from its pinned frames until the buffer has them.
+        if (cue_ && cue_->frames != nullptr && !cueCaughtUp()) {
+            DEBUG_TIME_END(next_frame_lock)
+            return nextCueFrame(force);
+        }
 
-        // If we have a reset request, set the cursor to the start of the video
-        // if it exists in our buffer.
-        if (requested_reset_.load() && !buffer_.empty()) {
-            std::lock_guard guard(buffer_mutex_);
+        // Hold the last frame until the decoder has caught up with a seek.
+        if (seek_pending_.load()) {
+            DEBUG_TIME_END(next_frame_lock)
+            return {};
+        }
 
-            requested_reset_ = false;
-            reverse_ = false;
+        if (!currentFrame()) {
+            DEBUG_TIME_END(next_frame_lock)
+            return {};
+        }
+
+        // A seek target shows up straight away and the clock starts over
+        // from there. Scrubbing holds it until the next seek.
+        if (seek_display_pending_) {
+            seek_display_pending_ = false;
+            clock_.reset();
+            recordSeekLatency();
+            cue_.reset();
+        } else if (scrubbing_) {
+            DEBUG_TIME_END(next_frame_lock)
+            return {};
+        }
 
-            bool found = false;
-            for (size_t i=0; i < VIDREVOLT_VIDEO_BUFFER_SIZE; i++) {
-                if (buffer_.at(i).first == 0) {
-                    found = true;
-                    cursor_ = static_cast<int>(i);
-                    break;
+        // The first frame after (re)starting the clock is shown straight
+        // away. After that, step over every frame whose time has come.
+        double rate = native_fps_.load() > 0 ? fps_.load() / native_fps_.load() : 1;
+        bool started = !clock_.tick(rate);
+        int stride = stride_.load();
+        int steps = 0;
+        while (!started && !finished_) {
+            // The last frame of a Once clip is over once its duration has
+            // passed too, which is when a Playlist cuts to the next clip.
+            if (ending_) {
+                if (force || clock_.consume(nominalDuration())) {
+                    finished_ = true;
                 }
-            }
 
-            if (!found) {
-                buffer_.clear();
+                break;
             }
-        }
 
-        if (buffer_.empty()) {
-            std::lock_guard guard(buffer_mutex_);
+            // With a stride above 1 the ends may fall between buffered frames.
+            int pos = buffer_.posAt(static_cast<size_t>(cursor_));
+            if (playback_ == Mirror) {
+                if (pos + stride > last_frame_.load()) {
+                    reverse_ = true;
+                } else if (pos - stride < 0) {
+                    reverse_ = false;
+                }
+            }
 
-            // Start from half the buffersize before the end of the video.
-            seek(-middle);
-            for (size_t i=0; i < VIDREVOLT_VIDEO_BUFFER_SIZE; i++) {
-                Frame frame = readFrame();
-                if (frame.first == 0) {
-                    cursor_ = static_cast<int>(i);
+            std::optional<double> duration = nextDuration();
+            if (!duration) {
+                // Time moves on while we wait for the decoder, but don't
+                // race ahead to catch up once it delivers.
+                if (force || clock_.consume(nominalDuration())) {
+                    underrun();
                 }
 
-                buffer_.push_back(frame);
+                clock_.stall(nominalDuration());
+                break;
             }
 
-            return;
+            if (force ? steps > 0 : !clock_.consume(duration.value())) {
+                break;
+            }
+
+            cursor_ += reverse_ ? -1 : 1;
+            steps++;
+
+            if (playback_ == Once && buffer_.posAt(static_cast<size_t>(cursor_)) + stride > last_frame_) {
+                ending_ = true;
+            }
         }
 
-        // Calculate current distance from center.
-        // Overshooting and undershooting are non-issues.
-        int diff, front_pos, back_pos;
-        {
-            std::lock_guard guard(buffer_mutex_);
+        if (finished_ || (!started && steps == 0)) {
+            DEBUG_TIME_END(next_frame_lock)
+            return {};
+        }
 
-            diff = cursor_ - middle;;
-            front_pos = buffer_.front().first;
-            back_pos = buffer_.back().first;
+        if (steps > 0) {
+            clock_.shown(steps);
         }
 
-        // Fill in order to make the current frame the center frame of the buffer.
-        if (diff < 0) {
-            // Absolute diff.
-            diff *= -1;
+        if (reverse_ ? middle_ - cursor_ > options_.refill_threshold :
+                cursor_ - middle_ > options_.refill_threshold) {
+            signalWork();
+        }
 
-            // Jump back by the amount we need to read to catch up.
-            seek(front_pos - diff);
+        updateAhead();
 
-            DEBUG_TIME_START(read_rev)
-            std::vector<Frame> tmp_buf;
-            for (int i=0; i < diff; i++) {
-                tmp_buf.push_back(readFrame());
-            }
-            DEBUG_TIME_END(read_rev)
+        DEBUG_TIME_END(next_frame_lock)
 
-            {
-                std::lock_guard guard(buffer_mutex_);
-                buffer_.insert(buffer_.begin(), tmp_buf.begin(), tmp_buf.end());
-                buffer_.erase(buffer_.end() - diff, buffer_.end());
+        return buffer_.at(static_cast<size_t>(cursor_)).mat;
+    }
 
-                // Compensate for the current frame moving forwards.
-                cursor_ += diff;
-            }
-        } else if (diff > 0) {
-            int pos = static_cast<int>(vid_->get(cv::CAP_PROP_POS_FRAMES));
-            if (pos != back_pos + 1) {
-                seek(back_pos + 1);
-            }
+    bool Video::isBlending() const {
+        return options_.blend;
+    }
 
-            std::vector<Frame> tmp_buf;
-            for (int i=0; i < diff; i++) {
-                tmp_buf.push_back(readFrame());
-            }
+    std::optional<FrameSource::Blend> Video::nextBlend() {
+        std::optional<cv::Mat> frame = nextFrame(false);
+        if (failed_.load()) {
+            return {};
+        }
 
-            {
-                std::lock_guard guard(buffer_mutex_);
-                buffer_.insert(buffer_.end(), tmp_buf.begin(), tmp_buf.end());
-                buffer_.erase(buffer_.begin(), buffer_.begin() + diff);
+        if (preloaded_.load() && !finished_ && !ending_) {
+            return arenaBlend();
+        }
+
+        std::lock_guard guard(buffer_mutex_);
 
-                // Compensate for the current frame moving backwards.
-                cursor_ -= diff;
+        // The end of a Once clip and pinned cue frames are shown as they are
+        if (finished_ || ending_ || (cue_ && cue_->frames != nullptr)) {
+            if (!frame) {
+                return {};
             }
+
+            Blend blend;
+            blend.from = frame.value();
+            blend.to = frame.value();
+
+            return blend;
+        }
+
+        if (seek_pending_.load() || cursor_ < 0 || static_cast<size_t>(cursor_) >= buffer_.size()) {
+            return {};
+        }
+
+        Blend blend;
+        size_t from = static_cast<size_t>(cursor_);
+        blend.from = buffer_.at(from).mat;
+        blend.from_pos = buffer_.posAt(from);
+
+        // Whatever the clock owes towards the next frame is how far along
+        // to it we are. Without one buffered, or while scrubbing, hold.
+        std::optional<double> duration = nextDuration();
+        if (duration && !scrubbing_) {
+            size_t to = static_cast<size_t>(cursor_ + (reverse_ ? -1 : 1));
+            blend.to = buffer_.at(to).mat;
+            blend.to_pos = buffer_.posAt(to);
+            blend.mix = std::clamp(clock_.getOwed() / duration.value(), 0.0, 1.0);
+        } else {
+            blend.to = blend.from;
+            blend.to_pos = blend.from_pos;
         }
+
+        return blend;
     }
 
-    void Video::setFPS(double fps) {
-        fps_ = fps;
+    std::optional<FrameSource::Blend> Video::arenaBlend() {
+        if (!arena_started_) {
+            return {};
+        }
+
+        int count = static_cast<int>(arena_->size());
+
+        Blend blend;
+        blend.from = arena_->at(static_cast<size_t>(arena_cursor_));
+        blend.from_pos = arena_cursor_;
+        blend.to = blend.from;
+        blend.to_pos = blend.from_pos;
+
+        int next = arena_cursor_ + (reverse_ ? -1 : 1);
+        bool wrapped = next < 0 || next >= count;
+        if (scrubbing_ || (wrapped && playback_ != Forward && playback_ != Reverse)) {
+            return blend;
+        }
+
+        next = (next + count) % count;
+        double duration = std::abs(arena_->ptsAt(static_cast<size_t>(next)) -
+                arena_->ptsAt(static_cast<size_t>(arena_cursor_)));
+        if (wrapped || duration <= 0) {
+            duration = 1000 / native_fps_.load();
+        }
+
+        blend.to = arena_->at(static_cast<size_t>(next));
+        blend.to_pos = next;
+        blend.mix = std::clamp(clock_.getOwed() / duration, 0.0, 1.0);
+
+        return blend;
     }
 
-    double Video::getFPS() const {
-        return fps_;
+    void Video::requestSeek(int pos, bool hold) {
+        std::lock_guard guard(buffer_mutex_);
+        cue_.reset();
+        seekLocked(pos, hold);
     }
 
-    void Video::start() {
-        if (running_.load()) {
+    void Video::seekLocked(int pos, bool hold) {
+        if (preloaded_.load()) {
+            pos = std::clamp(pos, 0, static_cast<int>(arena_->size()) - 1);
+
+            bool was_scrubbing = scrubbing_;
+            scrubbing_ = hold;
+            if (hold && was_scrubbing && arena_started_ && arena_cursor_ == pos) {
+                return;
+            }
+
+            arena_started_ = true;
+            arena_cursor_ = pos;
+            finished_ = false;
+            ending_ = false;
+            seeks_++;
+            seeks_buffered_++;
+            seek_requested_at_ = std::chrono::high_resolution_clock::now();
+            seek_display_pending_ = true;
+
             return;
         }
 
-        vid_ = std::make_unique<cv::VideoCapture>(path_);
+        pos = std::clamp(pos, 0, last_frame_.load());
+        std::optional<size_t> idx = findNear(pos);
 
-        if (!vid_->isOpened()) {
-            throw std::runtime_error("Unable to open video with path " + path_);
+        // Scrubbing asks for the same position every frame while the
+        // control is left alone.
+        bool was_scrubbing = scrubbing_;
+        scrubbing_ = hold;
+        if (hold && was_scrubbing && !seek_pending_.load() && idx && static_cast<int>(idx.value()) == cursor_) {
+            return;
         }
 
-        // Explore metadata
-        // Go to end of file
-        vid_->set(cv::CAP_PROP_POS_AVI_RATIO, 1);
-        total_frames_ = static_cast<int>(vid_->get(cv::CAP_PROP_POS_FRAMES));
-        last_frame_ = total_frames_ - 1;
-        length_ms = vid_->get(cv::CAP_PROP_POS_MSEC);
-        vid_->set(cv::CAP_PROP_POS_AVI_RATIO, 0);
+        finished_ = false;
+        ending_ = false;
+        seeks_++;
+        seek_requested_at_ = std::chrono::high_resolution_clock::now();
+        seek_display_pending_ = true;
+
+        if (idx) {
+            cursor_ = static_cast<int>(idx.value());
+            seek_pending_ = false;
+            seeks_buffered_++;
+            updateAhead();
+        } else {
+            seek_pos_ = pos;
+            seek_pending_ = true;
+        }
 
-        // This is a guess, apparently it can be wrong
-        total_frames_ = static_cast<int>(vid_->get(cv::CAP_PROP_FRAME_COUNT));
-        if (total_frames_ < 0) {
-            throw std::runtime_error("Unable to accurately determine number of frames for " + path_);
+        // Either way the buffer wants centering on the new position.
+        signalWork();
+    }
+
+    void Video::cue(const std::string& name) {
+        auto found = cue_pos_.find(name);
+        if (found == cue_pos_.end()) {
+            throw std::runtime_error("No cue named " + name + " in " + path_);
         }
 
-        last_frame_ = total_frames_ - 1;
+        std::shared_ptr<const std::vector<Frame>> frames;
+        {
+            std::lock_guard guard(cue_mutex_);
+            auto pinned = cue_frames_.find(name);
+            if (pinned != cue_frames_.end()) {
+                frames = pinned->second;
+            }
+        }
 
-        fps_ = vid_->get(cv::CAP_PROP_FPS);
-        if (fps_ <= 0) {
-            throw std::runtime_error("Unable to accurately determine number FPS for " + path_);
+        // The buffer is rebuilt around the cue as for any other seek, and
+        // the pinned frames cover for it meanwhile.
+        std::lock_guard guard(buffer_mutex_);
+        seekLocked(found->second, false);
+
+        cue_ = TriggeredCue();
+        cue_->name = name;
+        if (!preloaded_.load() && frames != nullptr && !frames->empty()) {
+            cue_->frames = frames;
         }
+    }
 
-        running_ = true;
-        load_mutex_.lock();
-        thread_ = std::thread([this] {
-            next();
-            res_.width = buffer_.front().second.size().width;
-            res_.height = buffer_.front().second.size().height;
-            load_mutex_.unlock();
-
-            //DEBUG_TIME_DECLARE(work_wait)
-            while (running_.load()) {
-                {
-                    //DEBUG_TIME_START(work_wait)
-                    std::unique_lock<std::mutex> lk(work_ready_mutex_);
-                    work_ready_cv_.wait(lk, [this]{return work_ready_ || !running_.load();});
-                    //DEBUG_TIME_END(work_wait)
-                }
+    bool Video::cueCaughtUp() {
+        if (seek_pending_.load()) {
+            return false;
+        }
 
-                if (!running_.load()) {
-                    break;
-                }
+        int pos = cue_->frames->at(cue_->index).pos;
+        std::optional<size_t> idx = findNear(pos);
+        if (!idx) {
+            // Played past what the refill centred on, so aim it again.
+            seek_pos_ = pos;
+            seek_pending_ = true;
+            signalWork();
 
-                next();
+            return false;
+        }
 
-                {
-                    std::lock_guard lk(work_ready_mutex_);
-                    work_ready_ = false;
-                }
-            }
-        });
+        cursor_ = static_cast<int>(idx.value());
+        updateAhead();
+
+        // Nothing pinned was shown yet, so the buffer shows the cue instead
+        // and records it as it does a seek.
+        if (cue_->displayed) {
+            cue_.reset();
+        } else {
+            cue_->frames = nullptr;
+        }
+
+        return true;
     }
 
-    Resolution Video::getResolution() {
-        return res_;
+    std::optional<cv::Mat> Video::nextCueFrame(bool force) {
+        const std::vector<Frame>& frames = *cue_->frames;
+        double rate = native_fps_.load() > 0 ? fps_.load() / native_fps_.load() : 1;
+
+        if (!cue_->displayed) {
+            seek_display_pending_ = false;
+            clock_.reset();
+            clock_.tick(rate);
+            recordSeekLatency();
+
+            return frames.front().mat;
+        }
+
+        // Pinned frames run forwards, reversed clips wait on the first one.
+        bool started = !clock_.tick(rate);
+        double nominal = 1000 / native_fps_.load();
+        int steps = 0;
+        while (!started && !reverse_ && cue_->index + 1 < frames.size()) {
+            double duration = frames.at(cue_->index + 1).pts_ms - frames.at(cue_->index).pts_ms;
+            if (duration <= 0) {
+                duration = nominal;
+            }
+
+            if (force ? steps > 0 : !clock_.consume(duration)) {
+                break;
+            }
+
+            cue_->index++;
+            steps++;
+        }
+
+        if (steps == 0) {
+            // Out of pinned frames before the decoder caught up
+            clock_.stall(nominal);
+
+            return {};
+        }
+
+        clock_.shown(steps);
+
+        return frames.at(cue_->index).mat;
     }
 
-    void Video::flipPlayback() {
-        setReverse(!reverse_);
+    void Video::pinCues() {
+        try {
+            // A decoder of our own, like preload()
+            std::unique_ptr<decode::Backend> backend = openBackend(options_.backend, path_);
+
+            for (const auto& [name, pos] : cue_pos_) {
+                auto frames = std::make_shared<std::vector<Frame>>();
+                backend->seek(pos);
+
+                decode::Frame frame;
+                while (!cues_cancelled_.load() && frames->size() < options_.cue_frames && backend->read(frame)) {
+                    // Clip frames can be views of the backend's mapping,
+                    // which goes away with it.
+                    frame.mat = frame.mat.clone();
+                    frames->push_back(frame);
+                }
+
+                if (cues_cancelled_.load()) {
+                    return;
+                }
+
+                std::lock_guard guard(cue_mutex_);
+                cue_frames_[name] = frames;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "WARNING: Unable to pin cues of " << path_ << ": " << e.what() << std::endl;
+        }
     }
 
-    void Video::waitForLoaded() {
-        std::lock_guard<std::mutex> mut(load_mutex_);
+    std::optional<size_t> Video::findNear(int pos) const {
+        // Buffered frames are stride_ apart, any within that covers pos.
+        int stride = stride_.load();
+        for (size_t i = 0; i < buffer_.size(); i++) {
+            if (std::abs(buffer_.posAt(i) - pos) < stride) {
+                return i;
+            }
+        }
+
+        return {};
     }
 
-    void Video::setReverse(bool t) {
-        reverse_ = t;
+    void Video::recordSeekLatency() {
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::high_resolution_clock::now() - seek_requested_at_;
+
+        seeks_shown_++;
+        seek_latency_last_ms_ = elapsed.count();
+        seek_latency_max_ms_ = std::max(seek_latency_max_ms_, elapsed.count());
+        seek_latency_avg_ms_ += (elapsed.count() - seek_latency_avg_ms_) / static_cast<double>(seeks_shown_);
+
+        if (cue_ && !cue_->displayed) {
+            cue_->displayed = true;
+            cues_shown_++;
+            cue_latency_last_ms_ = elapsed.count();
+            cue_latency_max_ms_ = std::max(cue_latency_max_ms_, elapsed.count());
+            cue_latency_avg_ms_ += (elapsed.count() - cue_latency_avg_ms_) / static_cast<double>(cues_shown_);
+
+            std::cerr << "Cue " << cue_->name << " of " << path_ << " shown " << elapsed.count() <<
+                "ms after trigger" << (cue_->frames != nullptr ? " (pinned)" : "") << std::endl;
+        }
     }
 
-    void Video::stop() {
-        running_ = false;
-        {
-            std::lock_guard guard(work_ready_mutex_);
-            work_ready_cv_.notify_one();
+    std::optional<double> Video::nextDuration() const {
+        int next = cursor_ + (reverse_ ? -1 : 1);
+        if (next < 0 || static_cast<size_t>(next) >= buffer_.size()) {
+            return {};
         }
-        if (thread_.joinable()) {
-            thread_.join();
+
+        size_t from = static_cast<size_t>(cursor_);
+        size_t to = static_cast<size_t>(next);
+
+        // Timestamps jump back where the clip loops, so fall back on the
+        // nominal frame rate there.
+        bool wrapped = reverse_ ? buffer_.posAt(to) > buffer_.posAt(from) : buffer_.posAt(to) < buffer_.posAt(from);
+        double duration = std::abs(buffer_.ptsAt(to) - buffer_.ptsAt(from));
+        if (wrapped || duration <= 0) {
+            return nominalDuration();
+        }
+
+        return duration;
+    }
+
+    int Video::wrap(int pos) const {
+        return ((pos % total_frames_) + total_frames_) % total_frames_;
+    }
+
+    double Video::nominalDuration() const {
+        return stride_.load() * 1000 / native_fps_.load();
+    }
+
+    void Video::underrun() {
+        underruns_++;
+        if (options_.adaptive) {
+            grow_requested_ = true;
+            signalWork();
+        }
+
+        // Once the buffer runs dry it usually does so every frame for a
+        // while, so summarise instead. Scripts can watch videoStats().
+        auto now = std::chrono::high_resolution_clock::now();
+        if (underrun_logged_at_ &&
+                now - underrun_logged_at_.value() < std::chrono::milliseconds(VIDREVOLT_VIDEO_UNDERRUN_LOG_MS)) {
+            return;
+        }
+
+        size_t underruns = underruns_.load();
+        double refill_avg_ms = 0;
+        double refill_max_ms = 0;
+        double decode_fps = 0;
+        {
+            std::lock_guard guard(stats_mutex_);
+            refill_avg_ms = refill_avg_ms_;
+            refill_max_ms = refill_max_ms_;
+            if (refill_total_ms_ > 0) {
+                decode_fps = static_cast<double>(frames_decoded_.load()) * 1000 / refill_total_ms_;
+            }
+        }
+
+        std::cerr << "WARNING: Video buffer exceeded " << underruns - underruns_logged_ << " time(s)";
+        if (underrun_logged_at_) {
+            std::chrono::duration<double> since = now - underrun_logged_at_.value();
+            std::cerr << " in " << since.count() << "s";
+        }
+        std::cerr << " (refill avg/max " << refill_avg_ms << "/" << refill_max_ms << "ms, decoding " <<
+            decode_fps << "fps). Try a lower resolution video or increase key frames. Path:" << path_ << std::endl;
+
+        underrun_logged_at_ = now;
+        underruns_logged_ = underruns;
+    }
+
+    std::optional<Video::Frame> Video::currentFrame() {
+        if (!loaded_.load()) {
+            return {};
+        }
+
+        if (cursor_ < 0 || static_cast<size_t>(cursor_) >= buffer_.size()) {
+            underrun();
+
+            return {};
+        } else {
+            return buffer_.at(static_cast<size_t>(cursor_));
+        }
+    }
+
+    Video::Frame Video::readFrame(int stride) {
+        DEBUG_TIME_START(read_single)
+        decode::Backend& backend = decoder();
+        decode::Frame frame;
+        if (!backend.read(frame)) {
+            backend.seek(0);
+
+            return readFrame(stride);
+        }
+
+        frames_decoded_++;
+        // Keeping frames around for others only pays when there are some
+        if (shared_.use_count() > 1) {
+            shared_->publish(frame, this);
+        }
+        FrameCache::getInstance().put(cacheKey(), frame);
+
+        // The frames in between will never be shown, so don't convert them.
+        for (int i=1; i < stride; i++) {
+            if (!backend.grab()) {
+                backend.seek(0);
+                backend.grab();
+            }
+        }
+
+        frames_skipped_ += static_cast<size_t>(stride - 1);
+        decode_pos_ = backend.tell();
+
+        DEBUG_TIME_END(read_single)
+
+        return frame;
+    }
+
+    void Video::seek(int pos) {
+        DEBUG_TIME_START(seek)
+        decoder().seek(wrap(pos));
+        decode_pos_ = wrap(pos);
+        DEBUG_TIME_END(seek)
+    }
+
+    void Video::seekNear(int pos) {
+        decode::Backend& backend = decoder();
+        int current = backend.tell();
+        if (current == pos) {
+            return;
+        }
+
+        // Already inside the target's GOP: skipping ahead without
+        // converting is cheaper than a seek, which decodes from the
+        // keyframe again.
+        if (index_ != nullptr && index_->isReady() && current < pos &&
+                index_->keyframeBefore(pos) <= current) {
+            while (current < pos && backend.grab()) {
+                current++;
+            }
+
+            decode_pos_ = current;
+
+            if (current == pos) {
+                return;
+            }
+        }
+
+        seek(pos);
+    }
+
+    double Video::getRemainingMS() {
+        // Frame positions are in the clip's own rate, whatever setFPS says
+        return length_ms - decode_pos_.load() * 1000 / native_fps_.load();
+    }
+
+    void Video::next() {
+        // Seeks that missed the buffer rebuild it around the target.
+        if (seek_pending_.load()) {
+            int target;
+            {
+                std::lock_guard guard(buffer_mutex_);
+                target = seek_pos_;
+            }
+
+            fill(target);
+
+            std::lock_guard guard(buffer_mutex_);
+            if (seek_pos_ == target) {
+                seek_pending_ = false;
+            } else {
+                // Moved on while we were decoding
+                signalWork();
+            }
+
+            return;
+        }
+
+        // If we have a reset request, set the cursor to the start of the video
+        // if it exists in our buffer.
+        if (requested_reset_.load() && !buffer_.empty()) {
+            std::lock_guard guard(buffer_mutex_);
+
+            requested_reset_ = false;
+            reverse_ = false;
+
+            auto start_idx = buffer_.find(0);
+            if (start_idx) {
+                cursor_ = static_cast<int>(start_idx.value());
+                updateAhead();
+            } else {
+                buffer_.clear();
+            }
+        }
+
+        if (buffer_.empty()) {
+            // Rebuilding after an eviction resumes where we left off,
+            // otherwise start at the beginning.
+            int center = resume_pos_;
+            if (requested_reset_.exchange(false)) {
+                reverse_ = false;
+                center = 0;
+            }
+
+            fill(center);
+            return;
+        }
+
+        // Count how many frames each side of the cursor is short of the
+        // middle. With a full buffer at most one side can be short.
+        int behind_short, ahead_short, front_pos, back_pos;
+        {
+            std::lock_guard guard(buffer_mutex_);
+
+            int capacity = static_cast<int>(buffer_.capacity());
+            int size = static_cast<int>(buffer_.size());
+
+            behind_short = middle_ - cursor_;
+            ahead_short = (capacity - 1 - middle_) - (size - 1 - cursor_);
+            front_pos = buffer_.front().pos;
+            back_pos = buffer_.back().pos;
+        }
+
+        // Fill in order to make the current frame the center frame of the buffer.
+        if (behind_short > 0 && (reverse_ || ahead_short <= 0)) {
+            fillBehind(front_pos, behind_short);
+        } else if (ahead_short > 0) {
+            fillAhead(back_pos, ahead_short);
+        }
+    }
+
+    void Video::fillBehind(int front_pos, int count) {
+        int stride = stride_.load();
+
+        // Mirror turns around at the first frame instead of wrapping.
+        if (playback_ == Mirror) {
+            count = std::min(count, front_pos / stride);
+        }
+
+        if (count <= 0) {
+            return;
+        }
+
+        DEBUG_TIME_START(refill)
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Newest-first, so pushing each onto the front leaves the buffer in
+        // playback order. Frames left over from an earlier refill go first.
+        std::vector<Frame> tmp_buf = takeStaged(front_pos - stride, -stride, count);
+        int remaining = count - static_cast<int>(tmp_buf.size());
+        int next_front = front_pos - static_cast<int>(tmp_buf.size()) * stride;
+
+        if (remaining > 0) {
+            int room, limit;
+            {
+                std::lock_guard guard(buffer_mutex_);
+                room = static_cast<int>(buffer_.capacity()) - 1 - cursor_ - static_cast<int>(tmp_buf.size());
+                limit = static_cast<int>(buffer_.capacity());
+            }
+
+            // Seeking decodes from the previous keyframe anyway, so read the
+            // whole GOP from there, once, forwards. As much of it as fits
+            // behind the cursor goes into the buffer and the rest is staged
+            // for the next reverse refill instead of being decoded again.
+            int first = next_front - remaining * stride;
+            int keep = remaining;
+            int span = remaining;
+            if (index_ != nullptr && index_->isReady() && first >= 0) {
+                int gop = (next_front - index_->keyframeBefore(first)) / stride;
+                keep = std::clamp(gop, remaining, std::max(remaining, room));
+                span = std::min(std::max(gop, remaining), keep + limit);
+            }
+
+            seekNear(next_front - span * stride);
+
+            DEBUG_TIME_START(read_rev)
+            std::vector<Frame> decoded;
+            for (int i=0; i < span; i++) {
+                decoded.push_back(readFrame(stride));
+            }
+            DEBUG_TIME_END(read_rev)
+
+            auto kept = decoded.end() - keep;
+            stage(decoded.begin(), kept, next_front);
+            tmp_buf.insert(tmp_buf.end(), std::make_reverse_iterator(decoded.end()),
+                    std::make_reverse_iterator(kept));
+        }
+
+        {
+            DEBUG_TIME_START(refill_lock)
+            std::lock_guard guard(buffer_mutex_);
+
+            // Prepending overwrites the slots at the back.
+            std::vector<Frame> dropped;
+            for (auto& frame : tmp_buf) {
+                if (buffer_.full()) {
+                    dropped.push_back(buffer_.back());
+                }
+
+                buffer_.pushFront(frame);
+            }
+
+            // Mirror will play those again once it turns around at the
+            // first frame, so hold on to them if that is close.
+            int new_front = buffer_.front().pos;
+            if (playback_ == Mirror && new_front < static_cast<int>(buffer_.capacity()) * stride) {
+                stage(dropped.begin(), dropped.end(), buffer_.back().pos);
+            }
+
+            // Compensate for the current frame moving forwards.
+            cursor_ += static_cast<int>(tmp_buf.size());
+            updateAhead();
+            DEBUG_TIME_END(refill_lock)
+        }
+
+        recordRefill(start);
+        DEBUG_TIME_END(refill)
+    }
+
+    void Video::fillAhead(int back_pos, int count) {
+        int stride = stride_.load();
+
+        // Mirror turns around at the last frame instead of wrapping.
+        if (playback_ == Mirror) {
+            count = std::min(count, (last_frame_.load() - back_pos) / stride);
+        }
+
+        if (count <= 0) {
+            return;
+        }
+
+        DEBUG_TIME_START(refill)
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<Frame> tmp_buf = takeStaged(back_pos + stride, stride, count);
+        int remaining = count - static_cast<int>(tmp_buf.size());
+        if (remaining > 0) {
+            seekNear(back_pos + (1 + static_cast<int>(tmp_buf.size())) * stride);
+
+            for (int i=0; i < remaining; i++) {
+                tmp_buf.push_back(readFrame(stride));
+            }
+        }
+
+        {
+            DEBUG_TIME_START(refill_lock)
+            std::lock_guard guard(buffer_mutex_);
+
+            // Appending overwrites the slots at the front.
+            std::vector<Frame> dropped;
+            for (auto& frame : tmp_buf) {
+                if (buffer_.full()) {
+                    dropped.push_back(buffer_.front());
+                }
+
+                buffer_.pushBack(frame);
+            }
+
+            // Mirror will play those again once it turns around at the
+            // last frame, so hold on to them if that is close.
+            int new_back = buffer_.back().pos;
+            if (playback_ == Mirror &&
+                    last_frame_.load() - new_back < static_cast<int>(buffer_.capacity()) * stride) {
+                stage(dropped.begin(), dropped.end(), buffer_.front().pos);
+            }
+
+            // Compensate for the current frame moving backwards.
+            cursor_ -= static_cast<int>(dropped.size());
+            updateAhead();
+            DEBUG_TIME_END(refill_lock)
+        }
+
+        recordRefill(start);
+        DEBUG_TIME_END(refill)
+    }
+
+    std::vector<Video::Frame> Video::takeStaged(int from, int step, int count) {
+        // Staged frames first, then what other Videos of the file decoded,
+        // then the compressed cache
+        std::vector<Frame> frames;
+        for (int pos = from; static_cast<int>(frames.size()) < count; pos += step) {
+            auto it = staged_.find(pos);
+            if (it != staged_.end()) {
+                frames.push_back(it->second);
+                staged_.erase(it);
+                frames_reused_++;
+                continue;
+            }
+
+            std::optional<Frame> shared = shared_->get(pos);
+            if (shared) {
+                frames.push_back(shared.value());
+                frames_shared_++;
+                continue;
+            }
+
+            std::optional<Frame> cached = FrameCache::getInstance().get(cacheKey(), pos);
+            if (!cached) {
+                break;
+            }
+
+            frames.push_back(cached.value());
+            frames_cached_++;
+        }
+
+        return frames;
+    }
+
+    void Video::stage(std::vector<Frame>::const_iterator first, std::vector<Frame>::const_iterator last, int near) {
+        for (auto it = first; it != last; it++) {
+            staged_[it->pos] = *it;
+        }
+
+        // Never hold more than another buffer's worth, dropping whatever is
+        // furthest from where the next refill will read.
+        while (staged_.size() > buffer_.capacity()) {
+            if (std::abs(staged_.begin()->first - near) > std::abs(staged_.rbegin()->first - near)) {
+                staged_.erase(staged_.begin());
+            } else {
+                staged_.erase(std::prev(staged_.end()));
+            }
+        }
+    }
+
+    size_t Video::getStagedBytes() const {
+        size_t bytes = 0;
+        for (const auto& kv : staged_) {
+            bytes += kv.second.mat.total() * kv.second.mat.elemSize();
+        }
+
+        return bytes;
+    }
+
+    void Video::recordRefill(std::chrono::high_resolution_clock::time_point start) {
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::high_resolution_clock::now() - start;
+
+        std::lock_guard guard(stats_mutex_);
+        timed_refills_++;
+        refill_last_ms_ = elapsed.count();
+        refill_total_ms_ += elapsed.count();
+        refill_max_ms_ = std::max(refill_max_ms_, elapsed.count());
+        refill_avg_ms_ += (elapsed.count() - refill_avg_ms_) / static_cast<double>(timed_refills_);
+    }
+
+    void Video::adapt() {
+        if (!options_.adaptive) {
+            return;
+        }
+
+        auto now = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> since_adapt = now - last_adapt_;
+
+        std::lock_guard guard(buffer_mutex_);
+
+        // Grow by half on an underrun, shrink by a quarter after a stable
+        // stretch, staying between the configured depth and the maximum.
+        size_t depth = buffer_.capacity();
+        size_t target = depth;
+        if (grow_requested_.exchange(false)) {
+            target = std::min<size_t>(VIDREVOLT_VIDEO_MAX_BUFFER_SIZE, depth + depth / 2);
+        } else if (since_adapt.count() > VIDREVOLT_VIDEO_STABLE_MS) {
+            target = std::max(options_.buffer_depth, depth - depth / 4);
+        }
+
+        if (target == depth) {
+            return;
+        }
+
+        last_adapt_ = now;
+
+        // When shrinking, keep the frames centered on the cursor.
+        int new_middle = static_cast<int>(target / 2);
+        size_t keep_from = 0;
+        if (target < buffer_.size()) {
+            keep_from = static_cast<size_t>(std::clamp(
+                    cursor_ - new_middle, 0, static_cast<int>(buffer_.size() - target)));
+        }
+
+        buffer_.setCapacity(target, keep_from);
+        cursor_ -= static_cast<int>(keep_from);
+        middle_ = new_middle;
+        updateAhead();
+    }
+
+    void Video::fill(int center) {
+        int stride = stride_.load();
+
+        // What is buffered now may well be wanted again, e.g. when jumping
+        // back and forth between seek targets, so stage it.
+        std::vector<Frame> previous;
+        {
+            std::lock_guard guard(buffer_mutex_);
+            for (size_t i=0; i < buffer_.size(); i++) {
+                previous.push_back(buffer_.at(i));
+            }
+        }
+        stage(previous.begin(), previous.end(), center);
+
+        // Start half a buffer before the center frame, wrapping around to
+        // the end of the video if need be.
+        std::vector<Frame> tmp_buf;
+        int center_idx = 0;
+        for (int i=0; i < static_cast<int>(buffer_.capacity()); i++) {
+            int pos = wrap(center + (i - middle_) * stride);
+
+            Frame frame;
+            std::vector<Frame> staged = takeStaged(pos, stride, 1);
+            if (staged.empty()) {
+                seekNear(pos);
+                frame = readFrame(stride);
+            } else {
+                frame = staged.front();
+            }
+
+            if (frame.pos == center) {
+                center_idx = i;
+            }
+
+            tmp_buf.push_back(frame);
+        }
+
+        std::lock_guard guard(buffer_mutex_);
+        buffer_.clear();
+        for (auto& frame : tmp_buf) {
+            buffer_.pushBack(frame);
+        }
+
+        cursor_ = center_idx;
+        updateAhead();
+    }
+
+    void Video::setFPS(double fps) {
+        fps_ = fps;
+        updateStride();
+    }
+
+    void Video::setRenderFPS(double fps) {
+        render_fps_ = fps;
+        updateStride();
+    }
+
+    void Video::updateStride() {
+        double render_fps = render_fps_.load();
+        if (render_fps <= 0) {
+            stride_ = 1;
+            return;
+        }
+
+        // Only every stride-th frame can be shown when playing faster than
+        // we render, so only those are buffered.
+        stride_ = std::max(1, static_cast<int>(std::lround(fps_.load() / render_fps)));
+    }
+
+    double Video::getFPS() const {
+        return fps_;
+    }
+
+    double Video::getNativeFPS() const {
+        return native_fps_;
+    }
+
+    int Video::getLastFrame() const {
+        return last_frame_;
+    }
+
+    void Video::describe() {
+        readMetadata();
+        startPinning();
+
+        // Probing may have opened the decoder, it waits for start() now
+        if (!running_.load() && backend_ != nullptr) {
+            backend_.reset();
+            decoder_open_ = false;
+        }
+    }
+
+    void Video::readMetadata() {
+        if (described_) {
+            return;
+        }
+
+        decoder_type_ = options_.backend;
+        decoder_path_ = path_;
+
+        // Probing can mean seeking to the end of the file, so reuse what an
+        // earlier launch found when the file hasn't changed since. Then the
+        // decoder isn't opened until a refill actually has to decode.
+        std::optional<MetadataCache::Entry> cached = MetadataCache::load(path_);
+        decode::Metadata md = cached ? cached->metadata : decoder().probe();
+        length_ms = md.duration_ms;
+        total_frames_ = md.frame_count;
+        if (total_frames_ <= 0) {
+            throw std::runtime_error("Unable to accurately determine number of frames for " + path_);
+        }
+
+        last_frame_ = total_frames_ - 1;
+
+        fps_ = md.fps;
+        native_fps_ = md.fps;
+        // NaN fails any comparison, so ask whether it is positive
+        if (!(fps_.load() > 0)) {
+            throw std::runtime_error("Unable to accurately determine number FPS for " + path_);
+        }
+
+        for (const auto& [name, seconds] : options_.cues) {
+            cue_pos_[name] = std::clamp(static_cast<int>(std::lround(seconds * native_fps_.load())), 0, last_frame_.load());
+        }
+
+        // Known before any frame is decoded, see Pipeline::addRenderStep()
+        if (md.resolution.width > 0 && md.resolution.height > 0) {
+            res_ = md.resolution;
+        }
+
+        metadata_ = md;
+        if (cached) {
+            metadata_cached_ = true;
+            cached_keyframes_ = cached->keyframes;
+        } else {
+            MetadataCache::store(path_, {md, {}});
+        }
+
+        described_ = true;
+    }
+
+    bool Video::isStarted() const {
+        return running_.load();
+    }
+
+    void Video::start() {
+        if (running_.load()) {
+            return;
+        }
+
+        readMetadata();
+        decode::Metadata md = metadata_;
+
+        ProxyTranscoder& proxies = ProxyTranscoder::getInstance();
+        std::optional<std::string> proxy = proxies.isEnabled() ? proxies.find(path_) : std::nullopt;
+
+        // Other Videos of the same file may decode what we're after
+        shared_ = SharedFrames::acquire(cacheKey());
+        shared_->reserve(options_.buffer_depth * 2);
+
+        if (options_.keyframe_index) {
+            index_ = std::make_unique<KeyframeIndex>(path_);
+
+            if (!cached_keyframes_.empty()) {
+                index_->load(cached_keyframes_);
+            } else if (!proxy) {
+                std::string path = path_;
+                bool want_proxy = proxies.isEnabled();
+                index_->buildAsync([path, md, want_proxy](const std::vector<int>& keyframes) {
+                    MetadataCache::store(path, {md, keyframes});
+
+                    if (want_proxy && ProxyTranscoder::isLongGOP(keyframes, md.frame_count)) {
+                        ProxyTranscoder::getInstance().request(path);
+                    }
+                });
+                proxy_wanted_ = want_proxy;
+            }
+        }
+
+        if (proxy) {
+            useProxy(proxy.value());
+        } else if (metadata_cached_ && proxies.isEnabled() &&
+                ProxyTranscoder::isLongGOP(cached_keyframes_, md.frame_count)) {
+            proxies.request(path_);
+            proxy_wanted_ = true;
+        }
+
+        // The initial fill is queued like any other refill, ahead of
+        // everything else since it has not loaded yet.
+        running_ = true;
+        FrameBudget::getInstance().add(this);
+        signalWork();
+
+        if (options_.preload) {
+            preload_thread_ = std::thread(&Video::preload, this);
+        }
+
+        startPinning();
+    }
+
+    void Video::startPinning() {
+        // Only needs the cue positions, describe() may have started already
+        if (cue_thread_.joinable() || cue_pos_.empty() || options_.cue_frames == 0) {
+            return;
+        }
+
+        cues_cancelled_ = false;
+        cue_thread_ = std::thread(&Video::pinCues, this);
+    }
+
+    std::string Video::cacheKey() const {
+        // Clips of the same file at different targets or formats don't share frames
+        return path_ + "@" + options_.target.str() + (options_.pixel_format == NV12 ? "-nv12" : "");
+    }
+
+    std::unique_ptr<decode::Backend> Video::openBackend(decode::Backend::Type type, const std::string& path) const {
+        std::unique_ptr<decode::Backend> backend = decode::Backend::create(type, path, options_.target);
+        if (!backend->setPixelFormat(options_.pixel_format)) {
+            throw std::runtime_error("Decode backend can't produce the requested pixel format for " + path);
+        }
+
+        return backend;
+    }
+
+    decode::Backend& Video::decoder() {
+        if (backend_ == nullptr) {
+            backend_ = openBackend(decoder_type_, decoder_path_);
+            decoder_open_ = true;
+        }
+
+        return *backend_;
+    }
+
+    void Video::useProxy(const std::string& proxy) {
+        // The proxy has to come out in the format we've been buffering
+        decoder_type_ = options_.pixel_format == BGR ? decode::Backend::OpenCV : decode::Backend::LibAV;
+        decoder_path_ = proxy;
+
+        // Every frame of a proxy is a keyframe, so pick up where we were.
+        if (backend_ != nullptr) {
+            int pos = backend_->tell();
+            std::unique_ptr<decode::Backend> backend = openBackend(decoder_type_, decoder_path_);
+            backend->seek(wrap(pos));
+            backend_ = std::move(backend);
+        }
+
+        if (index_ != nullptr) {
+            std::vector<int> keyframes(static_cast<size_t>(total_frames_));
+            std::iota(keyframes.begin(), keyframes.end(), 0);
+            index_->replace(keyframes);
+        }
+
+        proxy_active_ = true;
+    }
+
+    void Video::preload() {
+        try {
+            // A decoder of our own, the buffered one keeps playing meanwhile
+            std::unique_ptr<decode::Backend> backend = openBackend(options_.backend, path_);
+
+            std::unique_ptr<FrameArena> arena;
+            decode::Frame frame;
+            while (!preload_cancelled_.load() && backend->read(frame)) {
+                if (arena == nullptr) {
+                    arena = std::make_unique<FrameArena>(static_cast<size_t>(total_frames_),
+                            frame.mat.rows, frame.mat.cols, frame.mat.type());
+                }
+
+                // The probed count can be an estimate from the container,
+                // so make room for whatever frames are past it.
+                if (!arena->append(frame.mat, frame.pts_ms)) {
+                    arena->grow(arena->size() + arena->size() / 4 + 1);
+                    arena->append(frame.mat, frame.pts_ms);
+                }
+
+                preload_progress_ = std::min(1.0, static_cast<double>(arena->size()) / total_frames_);
+            }
+
+            if (preload_cancelled_.load() || arena == nullptr) {
+                return;
+            }
+
+            // What was decoded is what plays from here on
+            int decoded = static_cast<int>(arena->size());
+            if (decoded != total_frames_) {
+                std::cerr << "WARNING: Preloaded " << decoded << " frames of " << path_ <<
+                    ", probing found " << total_frames_ << std::endl;
+                last_frame_ = decoded - 1;
+            }
+
+            arena_ = std::move(arena);
+        } catch (const std::exception& e) {
+            std::cerr << "WARNING: Unable to preload " << path_ << ": " << e.what() << std::endl;
+            return;
+        }
+
+        preload_progress_ = 1;
+        preloaded_ = true;
+
+        // All that is left for the worker is freeing the buffer
+        signalWork();
+    }
+
+    std::optional<cv::Mat> Video::nextArenaFrame(bool force) {
+        int count = static_cast<int>(arena_->size());
+
+        // Carry on from wherever the buffer got to
+        if (!arena_started_) {
+            arena_started_ = true;
+
+            std::lock_guard guard(buffer_mutex_);
+            if (cursor_ >= 0 && static_cast<size_t>(cursor_) < buffer_.size()) {
+                arena_cursor_ = std::clamp(buffer_.posAt(static_cast<size_t>(cursor_)), 0, count - 1);
+            } else {
+                arena_cursor_ = std::clamp(handoff_pos_.load(), 0, count - 1);
+            }
+        }
+
+        if (seek_display_pending_) {
+            seek_display_pending_ = false;
+            clock_.reset();
+            recordSeekLatency();
+            cue_.reset();
+        } else if (scrubbing_) {
+            return {};
+        }
+
+        double nominal = 1000 / native_fps_.load();
+        bool started = !clock_.tick(fps_.load() / native_fps_.load());
+        int steps = 0;
+        while (!started && !finished_) {
+            if (ending_) {
+                if (force || clock_.consume(nominal)) {
+                    finished_ = true;
+                }
+
+                break;
+            }
+
+            if (playback_ == Mirror) {
+                if (arena_cursor_ == count - 1) {
+                    reverse_ = true;
+                } else if (arena_cursor_ == 0) {
+                    reverse_ = false;
+                }
+            }
+
+            int next = arena_cursor_ + (reverse_ ? -1 : 1);
+            bool wrapped = next < 0 || next >= count;
+            next = (next + count) % count;
+
+            double duration = std::abs(arena_->ptsAt(static_cast<size_t>(next)) -
+                    arena_->ptsAt(static_cast<size_t>(arena_cursor_)));
+            if (wrapped || duration <= 0) {
+                duration = nominal;
+            }
+
+            if (force ? steps > 0 : !clock_.consume(duration)) {
+                break;
+            }
+
+            arena_cursor_ = next;
+            steps++;
+
+            if (playback_ == Once && arena_cursor_ == count - 1) {
+                ending_ = true;
+            }
+        }
+
+        if (finished_ || (!started && steps == 0)) {
+            return {};
+        }
+
+        if (steps > 0) {
+            clock_.shown(steps);
+        }
+
+        return arena_->at(static_cast<size_t>(arena_cursor_));
+    }
+
+    Resolution Video::getResolution() {
+        return res_;
+    }
+
+    FrameSource::PixelFormat Video::getPixelFormat() const {
+        return options_.pixel_format;
+    }
+
+    void Video::flipPlayback() {
+        setReverse(!reverse_);
+    }
+
+    bool Video::isLoaded() const {
+        return loaded_.load();
+    }
+
+    bool Video::isFinished() const {
+        return finished_ || failed_.load();
+    }
+
+    void Video::waitForLoaded() {
+        std::unique_lock<std::mutex> lk(load_mutex_);
+        load_cv_.wait(lk, [this]{ return loaded_.load() || failed_.load(); });
+    }
+
+    void Video::setReverse(bool t) {
+        reverse_ = t;
+    }
+
+    void Video::stop() {
+        running_ = false;
+        FrameBudget::getInstance().remove(this);
+        DecodeScheduler::getInstance().cancel(this);
+
+        preload_cancelled_ = true;
+        if (preload_thread_.joinable()) {
+            preload_thread_.join();
+        }
+
+        cues_cancelled_ = true;
+        if (cue_thread_.joinable()) {
+            cue_thread_.join();
+        }
+
+        // Nobody accounts for our shared frames anymore
+        if (shared_) {
+            shared_->drop(this);
         }
     }
 }
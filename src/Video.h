@@ -9,6 +9,8 @@
 #include <string>
 #include <condition_variable>
 #include <future>
+#include <map>
+#include <vector>
 
 // OpenCV
 #include <opencv2/opencv.hpp>
@@ -16,14 +18,121 @@
 // Ours
 #include "Resolution.h"
 #include "FrameSource.h"
+#include "FrameArena.h"
+#include "FrameRing.h"
+#include "DecodeScheduler.h"
+#include "KeyframeIndex.h"
+#include "PlaybackClock.h"
+#include "SharedFrames.h"
+#include "decode/Backend.h"
 
-#define VIDREVOLT_VIDEO_MIDDLE 15
+// Defaults, see Video::Options
 #define VIDREVOLT_VIDEO_BUFFER_SIZE 30
+#define VIDREVOLT_VIDEO_WORK_THRESHOLD 3
+#define VIDREVOLT_VIDEO_CUE_FRAMES 8
+
+// Limits for adaptive buffering
+#define VIDREVOLT_VIDEO_MAX_BUFFER_SIZE 240
+#define VIDREVOLT_VIDEO_STABLE_MS 10000
+
+// Underruns are summarised at most this often instead of logged each frame
+#define VIDREVOLT_VIDEO_UNDERRUN_LOG_MS 5000
 
 namespace vidrevolt {
-    class Video : public FrameSource {
+    class Video : public FrameSource, public DecodeScheduler::Job {
         public:
-            using Frame = std::pair<int, cv::Mat>;
+            using Frame = FrameRing::Frame;
+
+            struct Options {
+                // Number of frames kept around the cursor
+                size_t buffer_depth = VIDREVOLT_VIDEO_BUFFER_SIZE;
+
+                // How far the cursor may drift from the middle of the
+                // buffer before a refill is requested
+                int refill_threshold = VIDREVOLT_VIDEO_WORK_THRESHOLD;
+
+                // Grow the buffer on underruns and shrink it back towards
+                // buffer_depth once playback has been stable for a while
+                bool adaptive = false;
+
+                // Index keyframes in the background so refills can read
+                // whole GOPs instead of seeking into the middle of one
+                bool keyframe_index = true;
+
+                decode::Backend::Type backend = decode::Backend::OpenCV;
+
+                // Decode the whole clip into memory in the background, then
+                // play it from there without touching the decoder again.
+                // Meant for short loops, the memory is not subject to
+                // FrameBudget.
+                bool preload = false;
+
+                // Decode frames scaled down to fit within this, there is no
+                // point buffering and uploading more than gets rendered.
+                // Zero in both dimensions keeps the clip's own resolution.
+                Resolution target;
+
+                // NV12 halves the memory and upload of BGR, the conversion
+                // happens on the GPU. Only the libav backend decodes to it.
+                PixelFormat pixel_format = BGR;
+
+                // Named positions in seconds, see cue(). The first
+                // cue_frames frames after each are decoded up front and kept
+                // for as long as the video is, outside FrameBudget.
+                std::map<std::string, double> cues;
+                size_t cue_frames = VIDREVOLT_VIDEO_CUE_FRAMES;
+
+                // Crossfade between the frames either side of the playhead
+                // on the GPU, so clips slowed below the render rate move
+                // smoothly instead of repeating frames. See nextBlend().
+                bool blend = false;
+            };
+
+            struct Stats {
+                DecodeScheduler::Job::WaitStats queue_wait;
+                size_t refills = 0;
+                bool in_focus = false;
+                size_t buffered_bytes = 0;
+                size_t evictions = 0;
+                size_t buffer_depth = 0;
+                size_t underruns = 0;
+                double refill_last_ms = 0;
+                double refill_avg_ms = 0;
+                double refill_max_ms = 0;
+
+                // Frames decoded per second spent refilling
+                double decode_fps = 0;
+                size_t buffered_frames = 0;
+                int frames_ahead = 0;
+                bool keyframes_indexed = false;
+                size_t frames_decoded = 0;
+                size_t frames_reused = 0;
+                size_t frames_cached = 0;
+                size_t frames_skipped = 0;
+                int stride = 1;
+                PlaybackClock::Stats playback;
+                size_t seeks = 0;
+                size_t seeks_buffered = 0;
+                double seek_latency_last_ms = 0;
+                double seek_latency_avg_ms = 0;
+                double seek_latency_max_ms = 0;
+                double preload_progress = 0;
+                size_t preload_bytes = 0;
+                bool proxy_active = false;
+                PixelFormat pixel_format = BGR;
+                size_t frame_bytes = 0;
+                size_t rgb_frame_bytes = 0;
+                size_t frames_shared = 0;
+                size_t shared_users = 0;
+                bool started = false;
+                bool decoder_open = false;
+                size_t cues_pinned = 0;
+                size_t cue_bytes = 0;
+                size_t cues_shown = 0;
+                double cue_latency_last_ms = 0;
+                double cue_latency_avg_ms = 0;
+                double cue_latency_max_ms = 0;
+            };
 
             enum Playback {
                 Mirror,
@@ -34,21 +143,53 @@ namespace vidrevolt {
 
             virtual ~Video();
             Video(const std::string& path, bool auto_reset, Playback pb=Forward);
+            Video(const std::string& path, bool auto_reset, Playback pb, const Options& opts);
             Video(const std::string& path, Playback pb);
 
+            // Read what the clip is (length, frame rate, cue positions)
+            // without keeping a decoder open or buffering anything, so it
+            // can be declared long before it is used. start() does this
+            // itself when it hasn't been done. Cue frames are pinned from
+            // here on, so cues fire warm before the clip is started.
+            void describe();
+            bool isStarted() const;
+
             void start();
             void stop();
 
             std::optional<cv::Mat> nextFrame() override;
+            PixelFormat getPixelFormat() const override;
             std::optional<cv::Mat> nextFrame(bool force);
 
+            bool isBlending() const override;
+            std::optional<Blend> nextBlend() override;
+
             Resolution getResolution();
 
             void outFocus();
             void inFocus();
+            bool isInFocus() const;
+            DecodeScheduler::Clock::time_point getOutFocusSince() const;
+
+            // Drop the frame buffer on the next worker pass; it is rebuilt
+            // at the same position when the video comes back into focus.
+            void requestEviction();
+            bool isEvictionPending() const;
+            size_t getBufferedBytes() const;
 
             void setReverse(bool t);
 
+            // Jump to a frame. Served straight from the buffer when it is
+            // there, otherwise the decoder rebuilds the buffer around it.
+            // With hold the clip stays on that frame (scrubbing) until the
+            // next seek without it.
+            void requestSeek(int pos, bool hold = false);
+
+            // Jump to a named cue, see Options::cues. Once its frames are
+            // pinned they play until the buffer has caught up, so the cue
+            // shows on the next frame whatever the decoder is doing.
+            void cue(const std::string& name);
+
             void flipPlayback();
 
             std::string getPath() const;
@@ -58,31 +199,109 @@ namespace vidrevolt {
             void setFPS(double fps);
             double getFPS() const;
 
+            // Frame rate of the file itself, regardless of setFPS()
+            double getNativeFPS() const;
+            int getLastFrame() const;
+
+            // Rate frames are actually being displayed at, see Pipeline::render()
+            void setRenderFPS(double fps);
+
             double getRemainingMS();
 
             void waitForLoaded();
+            bool isLoaded() const;
+
+            // Whether a Once playback has shown its last frame for as long
+            // as that frame lasts, or playback had to be given up on, see
+            // isFailed()
+            bool isFinished() const;
+
+            // Decoding hit an error and the video stopped, see work()
+            bool isFailed() const;
+
+            Stats getStats() const;
+
+            double getDeadlineMS() override;
+            void work() override;
 
         private:
+            void step();
+            void fail(const std::string& reason);
             void next();
+            void adapt();
+            void fill(int center);
+            void fillBehind(int front_pos, int count);
+            void fillAhead(int back_pos, int count);
+            void recordRefill(std::chrono::high_resolution_clock::time_point start);
+            std::vector<Frame> takeStaged(int from, int step, int count);
+            void stage(std::vector<Frame>::const_iterator first, std::vector<Frame>::const_iterator last, int near);
+            size_t getStagedBytes() const;
+            void evict();
             void seek(int pos);
-            Frame readFrame();
+            void seekNear(int pos);
+            Frame readFrame(int stride = 1);
             void signalWork();
+            void updateAhead();
+            std::optional<double> nextDuration() const;
+            double nominalDuration() const;
+            void underrun();
+            int wrap(int pos) const;
+            std::optional<size_t> findNear(int pos) const;
+            void recordSeekLatency();
+            void seekLocked(int pos, bool hold);
+            void startPinning();
+            void pinCues();
+            bool cueCaughtUp();
+            std::optional<cv::Mat> nextCueFrame(bool force);
+            void preload();
+            std::optional<cv::Mat> nextArenaFrame(bool force);
+            std::optional<Blend> arenaBlend();
+            void updateStride();
+            void readMetadata();
 
             double length_ms = 0;
 
+            // See describe()
+            bool described_ = false;
+            decode::Metadata metadata_;
+            bool metadata_cached_ = false;
+            std::vector<int> cached_keyframes_;
+
             // Constructor Parameters
             const std::string path_;
             std::atomic<bool> reverse_ = false;
             bool auto_reset_;
             const Playback playback_;
+            const Options options_;
             bool finished_ = false;
 
-            std::optional<std::chrono::high_resolution_clock::time_point> last_update_;
-            std::mutex buffer_mutex_;
-            std::unique_ptr<cv::VideoCapture> vid_;
-            std::thread thread_;
+            // On the last frame of a Once playback, finished_ follows
+            // once that frame's duration has passed
+            bool ending_ = false;
+
+            PlaybackClock clock_;
+            mutable std::mutex buffer_mutex_;
+            // Opened on the first decode, see decoder()
+            std::unique_ptr<decode::Backend> backend_;
+            decode::Backend::Type decoder_type_ = decode::Backend::OpenCV;
+            std::string decoder_path_;
+            std::atomic<bool> decoder_open_ = false;
+
+            // Where the decoder is, kept by the worker for other threads
+            std::atomic<int> decode_pos_ = 0;
+            decode::Backend& decoder();
+
+            std::shared_ptr<SharedFrames> shared_;
+            std::atomic<size_t> frames_shared_ = 0;
+            std::unique_ptr<KeyframeIndex> index_;
             std::atomic<bool> running_ = false;
-            double fps_ = 0;
+            std::atomic<double> fps_ = 0;
+            std::atomic<double> native_fps_ = 0;
+            std::atomic<double> render_fps_ = 0;
+
+            // Clip frames per buffered frame. Above 1 when the clip plays
+            // faster than we render and the frames in between are skipped.
+            std::atomic<int> stride_ = 1;
 
             std::atomic<int> last_frame_ = 0;
             int total_frames_ = 0;
@@ -90,17 +309,110 @@ namespace vidrevolt {
             std::atomic<bool> requested_reset_ = false;
 
             int cursor_ = 0;
-            std::vector<Frame> buffer_;
+            int middle_;
+            FrameRing buffer_;
+
+            // Decoded frames that didn't fit in the buffer yet: the rest of
+            // a GOP read for a reverse refill, or frames Mirror dropped just
+            // before turning around. Only touched from work().
+            std::map<int, Frame> staged_;
+            std::atomic<size_t> frames_decoded_ = 0;
+            std::atomic<size_t> frames_reused_ = 0;
+            std::atomic<size_t> frames_cached_ = 0;
+            std::atomic<size_t> frames_skipped_ = 0;
 
-            bool work_ready_ = false;
-            std::mutex work_ready_mutex_;
-            std::condition_variable work_ready_cv_;
+            std::atomic<size_t> underruns_ = 0;
+            std::atomic<bool> grow_requested_ = false;
+            std::chrono::high_resolution_clock::time_point last_adapt_;
+
+            // Frames buffered past the cursor in the direction of playback,
+            // readable by the scheduler without taking buffer_mutex_.
+            std::atomic<int> ahead_ = 0;
+            std::atomic<bool> in_focus_ = false;
+            std::atomic<DecodeScheduler::Clock::rep> out_focus_since_ = 0;
+            std::atomic<size_t> refills_ = 0;
+
+            mutable std::mutex stats_mutex_;
+            size_t timed_refills_ = 0;
+            double refill_last_ms_ = 0;
+            double refill_avg_ms_ = 0;
+            double refill_max_ms_ = 0;
+            double refill_total_ms_ = 0;
+
+            // Guarded by buffer_mutex_, see underrun()
+            std::optional<std::chrono::high_resolution_clock::time_point> underrun_logged_at_;
+            size_t underruns_logged_ = 0;
+
+            // Memory budget bookkeeping, see FrameBudget
+            std::atomic<size_t> buffered_bytes_ = 0;
+            std::atomic<size_t> evictions_ = 0;
+            std::atomic<bool> evict_requested_ = false;
+            std::atomic<bool> evicted_ = false;
+            int resume_pos_ = 0;
+
+            // Seeking and scrubbing, guarded by buffer_mutex_ apart from
+            // seek_pending_ which the scheduler reads too.
+            std::atomic<bool> seek_pending_ = false;
+            int seek_pos_ = 0;
+            bool seek_display_pending_ = false;
+            bool scrubbing_ = false;
+            std::chrono::high_resolution_clock::time_point seek_requested_at_;
+            size_t seeks_ = 0;
+            size_t seeks_buffered_ = 0;
+            size_t seeks_shown_ = 0;
+            double seek_latency_last_ms_ = 0;
+            double seek_latency_avg_ms_ = 0;
+            double seek_latency_max_ms_ = 0;
+
+            // Preloading, see Options::preload. Once preloaded_ is set the
+            // arena is read-only and its cursor belongs to nextFrame().
+            std::unique_ptr<FrameArena> arena_;
+            std::thread preload_thread_;
+            std::atomic<bool> preloaded_ = false;
+            std::atomic<bool> preload_cancelled_ = false;
+            std::atomic<double> preload_progress_ = 0;
+            std::atomic<int> handoff_pos_ = 0;
+            bool arena_started_ = false;
+            int arena_cursor_ = 0;
+
+            // Cues, see Options::cues. Positions are fixed by describe() or
+            // start(), whichever comes first, which also start cue_thread_
+            // pinning their frames. A triggered cue is guarded by
+            // buffer_mutex_ like the seek it rides on.
+            struct TriggeredCue {
+                std::string name;
+                std::shared_ptr<const std::vector<Frame>> frames;
+                size_t index = 0;
+                bool displayed = false;
+            };
+
+            std::map<std::string, int> cue_pos_;
+            std::map<std::string, std::shared_ptr<const std::vector<Frame>>> cue_frames_;
+            mutable std::mutex cue_mutex_;
+            std::thread cue_thread_;
+            std::atomic<bool> cues_cancelled_ = false;
+            std::optional<TriggeredCue> cue_;
+            size_t cues_shown_ = 0;
+            double cue_latency_last_ms_ = 0;
+            double cue_latency_avg_ms_ = 0;
+            double cue_latency_max_ms_ = 0;
 
             Resolution res_;
 
-            float error_ = 0;
+            // Worker-only after start(), besides the atomics
+            bool proxy_wanted_ = false;
+            std::atomic<bool> proxy_active_ = false;
+            void useProxy(const std::string& proxy);
+
+            std::string cacheKey() const;
+
+            // A backend for path at our target and pixel format
+            std::unique_ptr<decode::Backend> openBackend(decode::Backend::Type type, const std::string& path) const;
 
+            std::atomic<bool> loaded_ = false;
+            std::atomic<bool> failed_ = false;
             std::mutex load_mutex_;
+            std::condition_variable load_cv_;
     };
 }
 
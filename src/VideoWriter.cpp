@@ -18,10 +18,8 @@ namespace vidrevolt {
                 }
 
                 while (work_.size()) {
-                    cv::Mat frame = work_.front();
-                    cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
-                    flip(frame, frame, 0);
-                    writer_.write(frame);
+                    // Texture::read() already has it the way OpenCV wants
+                    writer_.write(work_.front());
                     work_.pop();
                 }
             }
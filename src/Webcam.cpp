@@ -1,5 +1,8 @@
 #include "Webcam.h"
 
+// Ours
+#include "FramePool.h"
+
 #include "debug.h"
 #define debug_time false
 
@@ -11,10 +14,11 @@ namespace vidrevolt {
     std::optional<cv::Mat> Webcam::nextFrame() {
         DEBUG_TIME_START(nextFrame)
 
+        // work() always decodes into a fresh buffer, so sharing frame_ is safe.
         cv::Mat frame;
         {
             std::lock_guard lk(frame_mutex_);
-            frame_.copyTo(frame);
+            frame = frame_;
         }
 
         signalWork();
@@ -30,15 +34,12 @@ namespace vidrevolt {
 
     void Webcam::work() {
         cv::Mat tmp_frame;
+        FramePool::assign(tmp_frame);
         vid_->read(tmp_frame);
-        if (!tmp_frame.empty()) {
-            cv::cvtColor(tmp_frame, tmp_frame, cv::COLOR_BGR2RGB);
-            flip(tmp_frame, tmp_frame, 0);
-        }
 
         {
             std::lock_guard lk(frame_mutex_);
-            tmp_frame.copyTo(frame_);
+            frame_ = tmp_frame;
         }
     }
 
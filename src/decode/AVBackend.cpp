@@ -0,0 +1,303 @@
+#include "decode/AVBackend.h"
+
+// STL
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+// Ours
+#include "FramePool.h"
+
+#include "debug.h"
+#define debug_time false
+
+DEBUG_TIME_DECLARE(av_decode)
+DEBUG_TIME_DECLARE(av_convert)
+
+namespace vidrevolt::decode {
+    AVBackend::AVBackend(const std::string& path, const Resolution& target, int threads) : path_(path) {
+        target_ = target;
+
+        try {
+            open(threads);
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    AVBackend::~AVBackend() {
+        close();
+    }
+
+    void AVBackend::open(int threads) {
+        int err = avformat_open_input(&fmt_, path_.c_str(), nullptr, nullptr);
+        if (err < 0) {
+            fail("Unable to open video", err);
+        }
+
+        err = avformat_find_stream_info(fmt_, nullptr);
+        if (err < 0) {
+            fail("Unable to read stream info", err);
+        }
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+        const AVCodec* decoder = nullptr;
+#else
+        AVCodec* decoder = nullptr;
+#endif
+        stream_idx_ = av_find_best_stream(fmt_, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+        if (stream_idx_ < 0 || decoder == nullptr) {
+            fail("Unable to find a decodable video stream", stream_idx_);
+        }
+
+        stream_ = fmt_->streams[stream_idx_];
+        fps_ = av_q2d(av_guess_frame_rate(fmt_, stream_, nullptr));
+
+        // An unknown rate comes back as 0/0, which is NaN
+        if (!(fps_ > 0)) {
+            throw std::runtime_error("Unable to determine the frame rate of " + path_);
+        }
+        start_ts_ = stream_->start_time == AV_NOPTS_VALUE ? 0 : stream_->start_time;
+
+        codec_ = avcodec_alloc_context3(decoder);
+        if (codec_ == nullptr) {
+            fail("Unable to allocate decoder", AVERROR(ENOMEM));
+        }
+
+        err = avcodec_parameters_to_context(codec_, stream_->codecpar);
+        if (err < 0) {
+            fail("Unable to configure decoder", err);
+        }
+
+        // Frame threading decodes several frames at once at the cost of a
+        // few frames of latency; slice threading splits up a single frame.
+        codec_->thread_count = threads;
+        codec_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        codec_->pkt_timebase = stream_->time_base;
+
+        // Decoders like MJPEG can skip detail at a power of two reduction,
+        // go as low as possible without dropping under the target.
+        Resolution src{codec_->width, codec_->height};
+        Resolution size = fit(src, target_);
+        int lowres = 0;
+        while (lowres < decoder->max_lowres &&
+                (src.width >> (lowres + 1)) >= size.width && (src.height >> (lowres + 1)) >= size.height) {
+            lowres++;
+        }
+        codec_->lowres = lowres;
+
+        err = avcodec_open2(codec_, decoder, nullptr);
+        if (err < 0) {
+            fail("Unable to open decoder", err);
+        }
+
+        pkt_ = av_packet_alloc();
+        frame_ = av_frame_alloc();
+        if (pkt_ == nullptr || frame_ == nullptr) {
+            fail("Unable to allocate frame", AVERROR(ENOMEM));
+        }
+    }
+
+    void AVBackend::close() {
+        sws_freeContext(sws_);
+        sws_ = nullptr;
+        av_frame_free(&frame_);
+        av_packet_free(&pkt_);
+        avcodec_free_context(&codec_);
+        avformat_close_input(&fmt_);
+    }
+
+    void AVBackend::fail(const std::string& what, int err) const {
+        char msg[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(err, msg, sizeof(msg));
+        throw std::runtime_error(what + " (" + msg + ") for " + path_);
+    }
+
+    Metadata AVBackend::probe() {
+        Metadata md;
+        md.fps = fps_;
+        // The stream's size, the decoder's is reduced by lowres
+        md.resolution.width = stream_->codecpar->width;
+        md.resolution.height = stream_->codecpar->height;
+
+        if (stream_->duration != AV_NOPTS_VALUE) {
+            md.duration_ms = toMS(stream_->duration + start_ts_);
+        } else if (fmt_->duration != AV_NOPTS_VALUE) {
+            md.duration_ms = static_cast<double>(fmt_->duration) * 1000 / AV_TIME_BASE;
+        }
+
+        if (stream_->nb_frames > 0) {
+            md.frame_count = static_cast<int>(stream_->nb_frames);
+        } else {
+            md.frame_count = static_cast<int>(std::lround(md.duration_ms * fps_ / 1000));
+        }
+
+        return md;
+    }
+
+    int AVBackend::framePos() const {
+        // Some streams carry no timestamps, then just count frames
+        if (frame_->best_effort_timestamp == AV_NOPTS_VALUE) {
+            return next_pos_;
+        }
+
+        return toPos(frame_->best_effort_timestamp);
+    }
+
+    int AVBackend::toPos(int64_t ts) const {
+        return static_cast<int>(std::lround(toMS(ts) * fps_ / 1000));
+    }
+
+    int64_t AVBackend::toTimestamp(int pos) const {
+        return start_ts_ + static_cast<int64_t>(std::llround(
+                    pos / fps_ / av_q2d(stream_->time_base)));
+    }
+
+    double AVBackend::toMS(int64_t ts) const {
+        return static_cast<double>(ts - start_ts_) * av_q2d(stream_->time_base) * 1000;
+    }
+
+    int AVBackend::tell() {
+        return next_pos_;
+    }
+
+    void AVBackend::seek(int pos) {
+        // Land on the keyframe at or before the target, then decode up to
+        // it so the next read is exactly pos.
+        int err = av_seek_frame(fmt_, stream_idx_, toTimestamp(pos), AVSEEK_FLAG_BACKWARD);
+        if (err < 0) {
+            fail("Unable to seek", err);
+        }
+
+        avcodec_flush_buffers(codec_);
+        eof_ = false;
+        pending_ = false;
+        next_pos_ = pos;
+
+        while (decodeNext()) {
+            if (framePos() >= pos) {
+                pending_ = true;
+                return;
+            }
+        }
+    }
+
+    bool AVBackend::decodeNext() {
+        DEBUG_TIME_START(av_decode)
+        while (true) {
+            int err = avcodec_receive_frame(codec_, frame_);
+            if (err == 0) {
+                DEBUG_TIME_END(av_decode)
+                return true;
+            } else if (err == AVERROR_EOF) {
+                return false;
+            } else if (err != AVERROR(EAGAIN)) {
+                fail("Unable to decode frame", err);
+            }
+
+            // The decoder wants more input
+            if (eof_) {
+                return false;
+            }
+
+            err = av_read_frame(fmt_, pkt_);
+            if (err < 0) {
+                // Drain whatever frames the decoder still holds
+                eof_ = true;
+                avcodec_send_packet(codec_, nullptr);
+                continue;
+            }
+
+            if (pkt_->stream_index == stream_idx_) {
+                err = avcodec_send_packet(codec_, pkt_);
+                if (err < 0 && err != AVERROR(EAGAIN)) {
+                    av_packet_unref(pkt_);
+                    fail("Unable to send packet to decoder", err);
+                }
+            }
+
+            av_packet_unref(pkt_);
+        }
+    }
+
+    bool AVBackend::nextDecoded() {
+        if (pending_) {
+            pending_ = false;
+        } else if (!decodeNext()) {
+            return false;
+        }
+
+        next_pos_ = framePos() + 1;
+        return true;
+    }
+
+    bool AVBackend::read(Frame& frame) {
+        if (!nextDecoded()) {
+            return false;
+        }
+
+        frame.pos = next_pos_ - 1;
+        frame.pts_ms = frame_->best_effort_timestamp == AV_NOPTS_VALUE ?
+            frame.pos * 1000 / fps_ : toMS(frame_->best_effort_timestamp);
+
+        DEBUG_TIME_START(av_convert)
+        int width = frame_->width;
+        int height = frame_->height;
+
+        // Against the stream's size, lowres may have left the decoder's
+        // frames smaller than that already.
+        Resolution size = fit({stream_->codecpar->width, stream_->codecpar->height}, target_);
+        if (target_.width <= 0 && target_.height <= 0) {
+            size = {width, height};
+        }
+
+        bool nv12 = format_ == FrameSource::NV12;
+        if (nv12) {
+            // Chroma is subsampled in pairs
+            size.width = std::max(2, size.width / 2 * 2);
+            size.height = std::max(2, size.height / 2 * 2);
+        }
+
+        sws_ = sws_getCachedContext(sws_,
+                width, height, static_cast<AVPixelFormat>(frame_->format),
+                size.width, size.height, nv12 ? AV_PIX_FMT_NV12 : AV_PIX_FMT_BGR24,
+                SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (sws_ == nullptr) {
+            throw std::runtime_error("Unable to convert frames of " + path_ +
+                    " to " + std::to_string(size.width) + "x" + std::to_string(size.height));
+        }
+
+        cv::Mat mat;
+        FramePool::assign(mat);
+
+        if (nv12) {
+            mat.create(size.height * 3 / 2, size.width, CV_8UC1);
+        } else {
+            mat.create(size.height, size.width, CV_8UC3);
+        }
+
+        // The UV plane follows the Y plane, unused for BGR
+        uint8_t* dst[] = {mat.data, mat.data + size.height * mat.step[0]};
+        int stride = static_cast<int>(mat.step[0]);
+        int dst_stride[] = {stride, stride};
+        sws_scale(sws_, frame_->data, frame_->linesize, 0, height, dst, dst_stride);
+        DEBUG_TIME_END(av_convert)
+
+        frame.mat = mat;
+
+        return true;
+    }
+
+    bool AVBackend::grab() {
+        return nextDecoded();
+    }
+
+    bool AVBackend::setPixelFormat(FrameSource::PixelFormat format) {
+        format_ = format;
+
+        return true;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef VIDREVOLT_DECODE_AVBACKEND_H_
+#define VIDREVOLT_DECODE_AVBACKEND_H_
+
+// STL
+#include <string>
+
+// FFmpeg
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+// Ours
+#include "decode/Backend.h"
+
+namespace vidrevolt::decode {
+    // Reads with libavformat/libavcodec directly. Unlike cv::VideoCapture
+    // this exposes decoder threading, exact timestamps and the seek flags.
+    // Scaling to the target happens in the same sws pass as the conversion,
+    // after a reduced resolution decode for codecs that support one.
+    class AVBackend : public Backend {
+        public:
+            // threads of zero lets libavcodec pick based on the core count
+            explicit AVBackend(const std::string& path, const Resolution& target = {}, int threads = 0);
+            ~AVBackend();
+
+            AVBackend(const AVBackend&) = delete;
+            AVBackend& operator=(const AVBackend&) = delete;
+
+            Metadata probe() override;
+            int tell() override;
+            void seek(int pos) override;
+            bool read(Frame& frame) override;
+            bool grab() override;
+            bool setPixelFormat(FrameSource::PixelFormat format) override;
+
+        private:
+            // The constructor's work. A constructor that throws never gets
+            // its destructor run, so it calls close() when this fails.
+            void open(int threads);
+            void close();
+
+            // Decode the next frame into frame_, false at end of stream.
+            bool decodeNext();
+
+            // Take frame_, decoding the next one unless a seek left one pending.
+            bool nextDecoded();
+
+            // Frame number of frame_
+            int framePos() const;
+
+            int toPos(int64_t ts) const;
+            int64_t toTimestamp(int pos) const;
+            double toMS(int64_t ts) const;
+
+            [[noreturn]] void fail(const std::string& what, int err) const;
+
+            const std::string path_;
+
+            AVFormatContext* fmt_ = nullptr;
+            AVCodecContext* codec_ = nullptr;
+            AVStream* stream_ = nullptr;
+            int stream_idx_ = -1;
+
+            AVPacket* pkt_ = nullptr;
+            AVFrame* frame_ = nullptr;
+            SwsContext* sws_ = nullptr;
+            FrameSource::PixelFormat format_ = FrameSource::BGR;
+
+            double fps_ = 0;
+            int64_t start_ts_ = 0;
+
+            int next_pos_ = 0;
+            bool pending_ = false;
+            bool eof_ = false;
+    };
+}
+
+#endif
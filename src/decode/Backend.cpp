@@ -0,0 +1,82 @@
+#include "decode/Backend.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Ours
+#include "decode/OpenCVBackend.h"
+#include "decode/AVBackend.h"
+#include "decode/ClipBackend.h"
+
+namespace vidrevolt::decode {
+    std::atomic<int> Backend::instances_ = 0;
+
+    Backend::Backend() {
+        instances_++;
+    }
+
+    Backend::~Backend() {
+        instances_--;
+    }
+
+    int Backend::getInstances() {
+        return instances_.load();
+    }
+
+    std::unique_ptr<Backend> Backend::create(Type type, const std::string& path, const Resolution& target) {
+        std::string ext = VIDREVOLT_CLIP_EXTENSION;
+        if (path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0) {
+            type = Clip;
+        }
+
+        switch (type) {
+            case OpenCV:
+                return std::make_unique<OpenCVBackend>(path, target);
+            case LibAV:
+                return std::make_unique<AVBackend>(path, target);
+            case Clip:
+                return std::make_unique<ClipBackend>(path, target);
+        }
+
+        throw std::runtime_error("Unknown decode backend for " + path);
+    }
+
+    Resolution Backend::fit(const Resolution& src, const Resolution& target) {
+        double scale = 1;
+        if (target.width > 0 && src.width > 0) {
+            scale = std::min(scale, static_cast<double>(target.width) / src.width);
+        }
+
+        if (target.height > 0 && src.height > 0) {
+            scale = std::min(scale, static_cast<double>(target.height) / src.height);
+        }
+
+        if (scale >= 1) {
+            return src;
+        }
+
+        Resolution res;
+        res.width = std::max(1, static_cast<int>(std::lround(src.width * scale)));
+        res.height = std::max(1, static_cast<int>(std::lround(src.height * scale)));
+
+        return res;
+    }
+
+    bool Backend::setPixelFormat(FrameSource::PixelFormat format) {
+        return format == FrameSource::BGR;
+    }
+
+    Backend::Type Backend::typeFromString(const std::string& name) {
+        if (name == "opencv") {
+            return OpenCV;
+        } else if (name == "libav") {
+            return LibAV;
+        } else if (name == "clip") {
+            return Clip;
+        }
+
+        throw std::runtime_error("Unknown decode backend '" + name + "', expected opencv, libav or clip");
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef VIDREVOLT_DECODE_BACKEND_H_
+#define VIDREVOLT_DECODE_BACKEND_H_
+
+// STL
+#include <atomic>
+#include <memory>
+#include <string>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "FrameSource.h"
+#include "Resolution.h"
+#include "decode/Frame.h"
+
+namespace vidrevolt::decode {
+    struct Metadata {
+        int frame_count = 0;
+        double fps = 0;
+        double duration_ms = 0;
+        Resolution resolution;
+    };
+
+    // Sequential reader with random access underneath a Video.
+    class Backend {
+        public:
+            enum Type {
+                OpenCV,
+                LibAV,
+                Clip
+            };
+
+            // Files with the .vrclip extension always get a ClipBackend.
+            // Frames larger than target are scaled down to fit it as they
+            // are decoded, see fit().
+            static std::unique_ptr<Backend> create(Type type, const std::string& path,
+                    const Resolution& target = {});
+            static Type typeFromString(const std::string& name);
+
+            // Largest size within target with the aspect ratio of src, never
+            // larger than src. Zero in either dimension leaves it unbounded.
+            static Resolution fit(const Resolution& src, const Resolution& target);
+
+            virtual ~Backend();
+
+            // Decoders open right now, across the process
+            static int getInstances();
+
+            virtual Metadata probe() = 0;
+
+            // Frame number of the next frame read() or grab() will return
+            virtual int tell() = 0;
+
+            // Position so the next frame read is exactly pos
+            virtual void seek(int pos) = 0;
+
+            // Decode and convert the next frame. False at the end of stream.
+            virtual bool read(Frame& frame) = 0;
+
+            // Skip the next frame without converting it
+            virtual bool grab() = 0;
+
+            // Convert frames read from now on to format instead of BGR.
+            // False when this backend can't.
+            virtual bool setPixelFormat(FrameSource::PixelFormat format);
+
+        protected:
+            Backend();
+
+            Resolution target_;
+
+        private:
+            static std::atomic<int> instances_;
+    };
+}
+
+#endif
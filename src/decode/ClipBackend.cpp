@@ -0,0 +1,152 @@
+#include "decode/ClipBackend.h"
+
+// STL
+#include <cstring>
+#include <stdexcept>
+
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// LZ4
+#include "lz4.h"
+
+// Ours
+#include "FramePool.h"
+
+namespace vidrevolt::decode {
+    ClipBackend::ClipBackend(const std::string& path, const Resolution& target) : path_(path) {
+        target_ = target;
+
+        int fd = open(path_.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open clip with path " + path_);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(ClipHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Not a clip, too short: " + path_);
+        }
+
+        // Private and writable so a frame handed out can be modified in
+        // place without touching the file.
+        size_ = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Unable to map clip " + path_);
+        }
+
+        data_ = static_cast<unsigned char*>(data);
+        header_ = reinterpret_cast<const ClipHeader*>(data_);
+
+        if (std::memcmp(header_->magic, VIDREVOLT_CLIP_MAGIC, sizeof(header_->magic)) != 0 ||
+                header_->version != VIDREVOLT_CLIP_VERSION) {
+            munmap(data_, size_);
+            throw std::runtime_error("Not a clip, or a clip from a different version: " + path_);
+        }
+
+        uint64_t index_end = header_->index_offset + uint64_t(header_->frame_count) * sizeof(ClipIndexEntry);
+        if (header_->frame_count == 0 || header_->index_offset % alignof(ClipIndexEntry) != 0 || index_end > size_) {
+            munmap(data_, size_);
+            throw std::runtime_error("Clip is truncated or was never finished: " + path_);
+        }
+
+        index_ = reinterpret_cast<const ClipIndexEntry*>(data_ + header_->index_offset);
+        for (uint32_t i = 0; i < header_->frame_count; i++) {
+            if (index_[i].offset + index_[i].size > size_) {
+                munmap(data_, size_);
+                throw std::runtime_error("Clip frame offsets point past the end of " + path_);
+            }
+        }
+
+        prefetch(0);
+    }
+
+    ClipBackend::~ClipBackend() {
+        munmap(data_, size_);
+    }
+
+    Metadata ClipBackend::probe() {
+        Metadata md;
+        md.frame_count = static_cast<int>(header_->frame_count);
+        md.fps = header_->fps;
+        md.duration_ms = header_->duration_ms;
+        md.resolution.width = static_cast<int>(header_->width);
+        md.resolution.height = static_cast<int>(header_->height);
+
+        return md;
+    }
+
+    int ClipBackend::tell() {
+        return pos_;
+    }
+
+    void ClipBackend::seek(int pos) {
+        pos_ = pos;
+        prefetch(pos_);
+    }
+
+    bool ClipBackend::read(Frame& frame) {
+        if (pos_ < 0 || pos_ >= static_cast<int>(header_->frame_count)) {
+            return false;
+        }
+
+        const ClipIndexEntry& entry = index_[pos_];
+        int rows = static_cast<int>(header_->height);
+        int cols = static_cast<int>(header_->width);
+
+        frame.pos = pos_;
+        frame.pts_ms = entry.pts_ms;
+
+        if (header_->compression == ClipLZ4) {
+            FramePool::assign(frame.mat);
+            frame.mat.create(rows, cols, CV_8UC3);
+
+            int raw_size = static_cast<int>(frame.mat.total() * frame.mat.elemSize());
+            int size = LZ4_decompress_safe(reinterpret_cast<const char*>(data_ + entry.offset),
+                    reinterpret_cast<char*>(frame.mat.data), static_cast<int>(entry.size), raw_size);
+            if (size != raw_size) {
+                throw std::runtime_error("Corrupt frame " + std::to_string(pos_) + " in clip " + path_);
+            }
+        } else {
+            frame.mat = cv::Mat(rows, cols, CV_8UC3, data_ + entry.offset);
+        }
+
+        Resolution size = fit({cols, rows}, target_);
+        if (size.width != cols || size.height != rows) {
+            cv::Mat scaled;
+            FramePool::assign(scaled);
+            cv::resize(frame.mat, scaled, cv::Size(size.width, size.height), 0, 0, cv::INTER_AREA);
+            frame.mat = scaled;
+        }
+
+        pos_++;
+        prefetch(pos_);
+
+        return true;
+    }
+
+    bool ClipBackend::grab() {
+        if (pos_ < 0 || pos_ >= static_cast<int>(header_->frame_count)) {
+            return false;
+        }
+
+        pos_++;
+
+        return true;
+    }
+
+    void ClipBackend::prefetch(int pos) const {
+        if (pos < 0 || pos >= static_cast<int>(header_->frame_count)) {
+            return;
+        }
+
+        // Frames start on page boundaries, see ClipFormat.h
+        const ClipIndexEntry& entry = index_[pos];
+        madvise(data_ + entry.offset, entry.size, MADV_WILLNEED);
+    }
+}
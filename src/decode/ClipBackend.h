@@ -0,0 +1,45 @@
+#ifndef VIDREVOLT_DECODE_CLIPBACKEND_H_
+#define VIDREVOLT_DECODE_CLIPBACKEND_H_
+
+// STL
+#include <string>
+
+// Ours
+#include "decode/Backend.h"
+#include "decode/ClipFormat.h"
+
+namespace vidrevolt::decode {
+    // Reads .vrclip files (see ClipFormat.h) through a memory mapping.
+    // There is no decoder state: seeking is setting a frame number and raw
+    // frames are handed out as headers into the mapping without a copy,
+    // unless they have to be scaled down to the target.
+    class ClipBackend : public Backend {
+        public:
+            explicit ClipBackend(const std::string& path, const Resolution& target = {});
+            ~ClipBackend();
+
+            ClipBackend(const ClipBackend&) = delete;
+            ClipBackend& operator=(const ClipBackend&) = delete;
+
+            Metadata probe() override;
+            int tell() override;
+            void seek(int pos) override;
+            bool read(Frame& frame) override;
+            bool grab() override;
+
+        private:
+            // Ask the kernel to start paging in the frame at pos
+            void prefetch(int pos) const;
+
+            const std::string path_;
+
+            unsigned char* data_ = nullptr;
+            size_t size_ = 0;
+            const ClipHeader* header_ = nullptr;
+            const ClipIndexEntry* index_ = nullptr;
+
+            int pos_ = 0;
+    };
+}
+
+#endif
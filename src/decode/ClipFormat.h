@@ -0,0 +1,52 @@
+#ifndef VIDREVOLT_DECODE_CLIPFORMAT_H_
+#define VIDREVOLT_DECODE_CLIPFORMAT_H_
+
+// STL
+#include <cstdint>
+
+// Layout of a .vrclip file, native (little-endian) byte order:
+//
+//   ClipHeader
+//   frame data, every frame starting on a VIDREVOLT_CLIP_ALIGN boundary
+//   ClipIndexEntry for each frame, starting at ClipHeader::index_offset
+//
+// Frames are stored exactly as decode::Frame holds them, BGR with the
+// top row first, either raw or LZ4 compressed. Raw frames can be used
+// straight out of a memory mapping.
+#define VIDREVOLT_CLIP_MAGIC "VRCLIP\x1a"
+
+// Version 1 held RGB bottom row first
+#define VIDREVOLT_CLIP_VERSION 2
+#define VIDREVOLT_CLIP_EXTENSION ".vrclip"
+#define VIDREVOLT_CLIP_ALIGN 4096
+
+namespace vidrevolt::decode {
+    enum ClipCompression : uint32_t {
+        ClipRaw = 0,
+        ClipLZ4 = 1
+    };
+
+    struct ClipHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t compression;
+        uint32_t width;
+        uint32_t height;
+        uint32_t frame_count;
+        uint32_t reserved;
+        double fps;
+        double duration_ms;
+        uint64_t index_offset;
+    };
+
+    struct ClipIndexEntry {
+        uint64_t offset;
+        uint64_t size;
+        double pts_ms;
+    };
+
+    static_assert(sizeof(ClipHeader) == 56, "ClipHeader must not be padded");
+    static_assert(sizeof(ClipIndexEntry) == 24, "ClipIndexEntry must not be padded");
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "decode/ClipWriter.h"
+
+// STL
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+// LZ4
+#include "lz4.h"
+
+namespace vidrevolt::decode {
+    ClipWriter::ClipWriter(const std::string& path, double fps, ClipCompression compression) :
+        path_(path), out_(path, std::ios::binary | std::ios::trunc) {
+
+        if (!out_) {
+            throw std::runtime_error("Unable to open clip for writing with path " + path_);
+        }
+
+        std::memcpy(header_.magic, VIDREVOLT_CLIP_MAGIC, sizeof(header_.magic));
+        header_.version = VIDREVOLT_CLIP_VERSION;
+        header_.compression = compression;
+        header_.fps = fps;
+
+        // Placeholder until close() knows the rest
+        out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    }
+
+    ClipWriter::~ClipWriter() {
+        if (closed_) {
+            return;
+        }
+
+        try {
+            close();
+        } catch (const std::exception& e) {
+            std::cerr << "WARNING: " << e.what() << std::endl;
+        }
+    }
+
+    void ClipWriter::write(const Frame& frame) {
+        if (closed_) {
+            throw std::runtime_error("Attempt to write to closed clip " + path_);
+        }
+
+        cv::Mat mat = frame.mat.isContinuous() ? frame.mat : frame.mat.clone();
+        if (mat.type() != CV_8UC3) {
+            throw std::runtime_error("Clips only hold 8-bit BGR frames, writing " + path_);
+        }
+
+        if (index_.empty()) {
+            header_.width = static_cast<uint32_t>(mat.cols);
+            header_.height = static_cast<uint32_t>(mat.rows);
+        } else if (mat.cols != static_cast<int>(header_.width) || mat.rows != static_cast<int>(header_.height)) {
+            throw std::runtime_error("Frame size changed part way through writing " + path_);
+        }
+
+        pad();
+
+        ClipIndexEntry entry;
+        entry.offset = static_cast<uint64_t>(out_.tellp());
+        entry.pts_ms = frame.pts_ms;
+
+        int raw_size = static_cast<int>(mat.total() * mat.elemSize());
+        if (header_.compression == ClipLZ4) {
+            std::vector<char> data(static_cast<size_t>(LZ4_compressBound(raw_size)));
+            int size = LZ4_compress_fast(reinterpret_cast<const char*>(mat.data), data.data(),
+                    raw_size, static_cast<int>(data.size()), 1);
+            if (size <= 0) {
+                throw std::runtime_error("Unable to compress frame for " + path_);
+            }
+
+            out_.write(data.data(), size);
+            entry.size = static_cast<uint64_t>(size);
+        } else {
+            out_.write(reinterpret_cast<const char*>(mat.data), raw_size);
+            entry.size = static_cast<uint64_t>(raw_size);
+        }
+
+        if (!out_) {
+            throw std::runtime_error("Unable to write frame to " + path_);
+        }
+
+        index_.push_back(entry);
+    }
+
+    void ClipWriter::close() {
+        if (closed_) {
+            return;
+        }
+
+        closed_ = true;
+
+        pad();
+        header_.index_offset = static_cast<uint64_t>(out_.tellp());
+        header_.frame_count = static_cast<uint32_t>(index_.size());
+        header_.duration_ms = header_.fps > 0 ? index_.size() * 1000 / header_.fps : 0;
+
+        out_.write(reinterpret_cast<const char*>(index_.data()),
+                static_cast<std::streamsize>(index_.size() * sizeof(ClipIndexEntry)));
+
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        out_.close();
+
+        if (!out_) {
+            throw std::runtime_error("Unable to finish writing clip " + path_);
+        }
+    }
+
+    void ClipWriter::pad() {
+        auto pos = static_cast<size_t>(out_.tellp());
+        size_t padding = (VIDREVOLT_CLIP_ALIGN - pos % VIDREVOLT_CLIP_ALIGN) % VIDREVOLT_CLIP_ALIGN;
+
+        static const char zeros[VIDREVOLT_CLIP_ALIGN] = {};
+        out_.write(zeros, static_cast<std::streamsize>(padding));
+    }
+}
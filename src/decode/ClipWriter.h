@@ -0,0 +1,38 @@
+#ifndef VIDREVOLT_DECODE_CLIPWRITER_H_
+#define VIDREVOLT_DECODE_CLIPWRITER_H_
+
+// STL
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Ours
+#include "decode/ClipFormat.h"
+#include "decode/Frame.h"
+
+namespace vidrevolt::decode {
+    // Writes a .vrclip file frame by frame, see ClipFormat.h.
+    class ClipWriter {
+        public:
+            ClipWriter(const std::string& path, double fps, ClipCompression compression);
+            ~ClipWriter();
+
+            // Frames are numbered in the order written
+            void write(const Frame& frame);
+
+            // Write the offset table and header. Called by the destructor
+            // if need be, but errors are only reported from here.
+            void close();
+
+        private:
+            void pad();
+
+            const std::string path_;
+            std::ofstream out_;
+            ClipHeader header_ = {};
+            std::vector<ClipIndexEntry> index_;
+            bool closed_ = false;
+    };
+}
+
+#endif
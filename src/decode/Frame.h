@@ -0,0 +1,20 @@
+#ifndef VIDREVOLT_DECODE_FRAME_H_
+#define VIDREVOLT_DECODE_FRAME_H_
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+namespace vidrevolt::decode {
+    struct Frame {
+        // Frame number, counted from the start of the stream
+        int pos = 0;
+
+        // Presentation timestamp, relative to the start of the stream
+        double pts_ms = 0;
+
+        // BGR (or see FrameSource::PixelFormat), top row first
+        cv::Mat mat;
+    };
+}
+
+#endif
@@ -0,0 +1,80 @@
+#include "decode/OpenCVBackend.h"
+
+// STL
+#include <stdexcept>
+
+// Ours
+#include "FramePool.h"
+
+#include "debug.h"
+#define debug_time false
+
+DEBUG_TIME_DECLARE(frame_processing)
+
+namespace vidrevolt::decode {
+    OpenCVBackend::OpenCVBackend(const std::string& path, const Resolution& target) :
+        path_(path), vid_(std::make_unique<cv::VideoCapture>(path)) {
+
+        target_ = target;
+
+        if (!vid_->isOpened()) {
+            throw std::runtime_error("Unable to open video with path " + path_);
+        }
+    }
+
+    Metadata OpenCVBackend::probe() {
+        Metadata md;
+
+        // Go to end of file
+        vid_->set(cv::CAP_PROP_POS_AVI_RATIO, 1);
+        md.duration_ms = vid_->get(cv::CAP_PROP_POS_MSEC);
+        vid_->set(cv::CAP_PROP_POS_AVI_RATIO, 0);
+
+        // This is a guess, apparently it can be wrong
+        md.frame_count = static_cast<int>(vid_->get(cv::CAP_PROP_FRAME_COUNT));
+        md.fps = vid_->get(cv::CAP_PROP_FPS);
+        md.resolution.width = static_cast<int>(vid_->get(cv::CAP_PROP_FRAME_WIDTH));
+        md.resolution.height = static_cast<int>(vid_->get(cv::CAP_PROP_FRAME_HEIGHT));
+
+        return md;
+    }
+
+    int OpenCVBackend::tell() {
+        return static_cast<int>(vid_->get(cv::CAP_PROP_POS_FRAMES));
+    }
+
+    void OpenCVBackend::seek(int pos) {
+        vid_->set(cv::CAP_PROP_POS_FRAMES, pos);
+    }
+
+    bool OpenCVBackend::read(Frame& frame) {
+        frame.pos = tell();
+
+        cv::Mat mat;
+        FramePool::assign(mat);
+        if (!vid_->read(mat)) {
+            return false;
+        }
+
+        frame.pts_ms = vid_->get(cv::CAP_PROP_POS_MSEC);
+
+        // Left as BGR top row first, see FrameSource::PixelFormat
+        DEBUG_TIME_START(frame_processing)
+        Resolution size = fit({mat.cols, mat.rows}, target_);
+        if (size.width != mat.cols || size.height != mat.rows) {
+            cv::Mat scaled;
+            FramePool::assign(scaled);
+            cv::resize(mat, scaled, cv::Size(size.width, size.height), 0, 0, cv::INTER_AREA);
+            mat = scaled;
+        }
+        DEBUG_TIME_END(frame_processing)
+
+        frame.mat = mat;
+
+        return true;
+    }
+
+    bool OpenCVBackend::grab() {
+        return vid_->grab();
+    }
+}
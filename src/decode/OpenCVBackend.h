@@ -0,0 +1,32 @@
+#ifndef VIDREVOLT_DECODE_OPENCVBACKEND_H_
+#define VIDREVOLT_DECODE_OPENCVBACKEND_H_
+
+// STL
+#include <memory>
+#include <string>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "decode/Backend.h"
+
+namespace vidrevolt::decode {
+    // Reads through cv::VideoCapture.
+    class OpenCVBackend : public Backend {
+        public:
+            explicit OpenCVBackend(const std::string& path, const Resolution& target = {});
+
+            Metadata probe() override;
+            int tell() override;
+            void seek(int pos) override;
+            bool read(Frame& frame) override;
+            bool grab() override;
+
+        private:
+            const std::string path_;
+            std::unique_ptr<cv::VideoCapture> vid_;
+    };
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "gl/FrameBlender.h"
+
+namespace vidrevolt {
+    namespace gl {
+        FrameBlender::FrameBlender() :
+            program_(std::make_shared<ShaderProgram>()) {
+
+            constexpr auto vert = R"V(
+                #version 410
+
+                layout (location = 0) in vec3 aPos;
+                out vec2 tc;
+
+                void main() {
+                    gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+                    tc = aPos.xy * .5 + .5;
+                }
+            )V";
+
+            constexpr auto frag = R"V(
+                #version 410
+
+                in vec2 tc;
+                out vec4 fragColor;
+
+                uniform sampler2D from_tex;
+                uniform sampler2D to_tex;
+                uniform bool from_flip;
+                uniform bool to_flip;
+                uniform float amount;
+
+                vec2 orient(vec2 st, bool flip) {
+                    return flip ? vec2(st.x, 1. - st.y) : st;
+                }
+
+                void main() {
+                    vec4 a = texture(from_tex, orient(tc, from_flip));
+                    vec4 b = texture(to_tex, orient(tc, to_flip));
+
+                    fragColor = vec4(mix(a.rgb, b.rgb, amount), 1.);
+                }
+            )V";
+
+            program_->loadShaderStr(GL_VERTEX_SHADER, vert, "internal-blend-vert.glsl");
+            program_->loadShaderStr(GL_FRAGMENT_SHADER, frag, "internal-blend-frag.glsl");
+            program_->compile();
+        }
+
+        size_t FrameBlender::fetch(const cv::Mat& frame, int pos, FrameSource::PixelFormat format,
+                std::optional<size_t> keep) {
+            if (pos >= 0) {
+                for (size_t i = 0; i < slots_.size(); i++) {
+                    if (slots_[i].pos == pos && slots_[i].current != nullptr) {
+                        return i;
+                    }
+                }
+            }
+
+            size_t i = keep && keep.value() == 0 ? 1 : 0;
+            Slot& slot = slots_[i];
+
+            if (format == FrameSource::NV12) {
+                if (slot.converter == nullptr) {
+                    slot.converter = std::make_unique<YUVConverter>();
+                }
+
+                slot.current = slot.converter->convert(frame);
+            } else {
+                if (slot.texture == nullptr) {
+                    slot.texture = std::make_shared<Texture>();
+                }
+
+                cv::Mat mat = frame;
+                slot.texture->populate(mat);
+                slot.current = slot.texture;
+            }
+
+            slot.pos = pos;
+
+            return i;
+        }
+
+        std::shared_ptr<Texture> FrameBlender::blend(const FrameSource::Blend& blend, FrameSource::PixelFormat format) {
+            // Hang on to the frame we are heading for if we have it already
+            std::optional<size_t> next;
+            for (size_t i = 0; i < slots_.size(); i++) {
+                if (blend.to_pos >= 0 && slots_[i].pos == blend.to_pos) {
+                    next = i;
+                }
+            }
+
+            size_t from = fetch(blend.from, blend.from_pos, format, next);
+
+            // Nothing to mix in
+            if (blend.mix <= 0 || (blend.from_pos >= 0 && blend.from_pos == blend.to_pos)) {
+                return slots_[from].current;
+            }
+
+            size_t to = fetch(blend.to, blend.to_pos, format, from);
+
+            Resolution res = slots_[from].current->getResolution();
+            if (out_ == nullptr || res_.width != res.width || res_.height != res.height) {
+                res_ = res;
+                out_ = std::make_shared<RenderOut>(res_, GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1);
+                out_->load();
+            }
+
+            GLint viewport[4];
+            GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+
+            out_->bind(program_);
+
+            std::shared_ptr<Texture> from_tex = slots_[from].current;
+            std::shared_ptr<Texture> to_tex = slots_[to].current;
+            program_->setUniform("from_tex", [from_tex](GLint& id) {
+                from_tex->bind(0);
+                glUniform1i(id, 0);
+            });
+
+            program_->setUniform("to_tex", [to_tex](GLint& id) {
+                to_tex->bind(1);
+                glUniform1i(id, 1);
+            });
+
+            program_->setUniform("from_flip", [from_tex](GLint& id) {
+                glUniform1i(id, from_tex->isFlipped() ? 1 : 0);
+            });
+
+            program_->setUniform("to_flip", [to_tex](GLint& id) {
+                glUniform1i(id, to_tex->isFlipped() ? 1 : 0);
+            });
+
+            float amount = static_cast<float>(blend.mix);
+            program_->setUniform("amount", [amount](GLint& id) {
+                glUniform1f(id, amount);
+            });
+
+            GLCall(glViewport(0, 0, res_.width, res_.height));
+            GLCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0));
+
+            out_->unbind(program_);
+            GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+
+            return out_->getSrcTex();
+        }
+    }
+}
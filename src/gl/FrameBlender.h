@@ -0,0 +1,56 @@
+#ifndef VIDREVOLT_GL_FRAMEBLENDER_H_
+#define VIDREVOLT_GL_FRAMEBLENDER_H_
+
+// STL
+#include <array>
+#include <memory>
+#include <optional>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "gl/RenderOut.h"
+#include "gl/ShaderProgram.h"
+#include "gl/Texture.h"
+#include "gl/YUVConverter.h"
+#include "FrameSource.h"
+#include "Resolution.h"
+
+namespace vidrevolt {
+    namespace gl {
+        // Crossfades the two frames of a FrameSource::Blend in a pass of
+        // its own. Both frames stay uploaded between calls, so stepping
+        // to the next pair uploads one new frame and a pair that hasn't
+        // changed uploads nothing.
+        class FrameBlender {
+            public:
+                FrameBlender();
+
+                // The blended result, valid until the next call
+                std::shared_ptr<Texture> blend(const FrameSource::Blend& blend, FrameSource::PixelFormat format);
+
+            private:
+                struct Slot {
+                    int pos = -1;
+                    std::shared_ptr<Texture> texture;
+                    std::unique_ptr<YUVConverter> converter;
+
+                    // What to sample, texture or the converter's output
+                    std::shared_ptr<Texture> current;
+                };
+
+                // Index of the slot holding frame pos, uploading it over
+                // the slot other than keep if none does.
+                size_t fetch(const cv::Mat& frame, int pos, FrameSource::PixelFormat format,
+                        std::optional<size_t> keep);
+
+                std::shared_ptr<ShaderProgram> program_;
+                std::array<Slot, 2> slots_;
+                std::shared_ptr<RenderOut> out_;
+                Resolution res_;
+        };
+    }
+}
+
+#endif
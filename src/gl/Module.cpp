@@ -38,6 +38,7 @@ namespace vidrevolt {
                         uniforms[toPrivateInputName(name) + "_as_tex"] = addr;
                         uniforms[toPrivateInputName(name) + "_is_tex"] = Value(true);
                         uniforms[toPrivateInputName(name) + "_res"] = addr + "resolution";
+                        uniforms[toPrivateInputName(name) + "_flip"] = addr + "flipped";
 
                         auto swiz = addr.getSwiz();
                         for (size_t i = 0; i < swiz.size(); i++) {
@@ -100,6 +101,7 @@ namespace vidrevolt {
                 uniform bool {{private_name}}_is_tex = false;
                 uniform bool {{private_name}}_is_set = false;
                 uniform vec2 {{private_name}}_res = vec2(0);
+                uniform bool {{private_name}}_flip = false;
                 uniform float {{private_name}}_shift = 0;
                 uniform float {{private_name}}_amp = 1;
 
@@ -118,6 +120,11 @@ namespace vidrevolt {
 
                     {{type}} ret;
                     if ({{private_name}}_is_tex) {
+                        // Frames straight from OpenCV have their top row first
+                        if ({{private_name}}_flip) {
+                            st.y = 1. - st.y;
+                        }
+
                         vec4 intermediate = texture({{private_name}}_as_tex, st);
                         {% if length > 1 %}
                             {% for i in range(length) %}
@@ -43,6 +43,11 @@ namespace vidrevolt {
                             glUniform1i(id, slot);
                             slot++;
                         });
+                    } else if (textures_.count(addr.withoutBack()) && addr.getBack() == "flipped") {
+                        bool flipped = textures_.at(addr.withoutBack())->isFlipped();
+                        program->setUniform(uni_name, [flipped](GLint& id) {
+                            glUniform1i(id, flipped ? 1 : 0);
+                        });
                     } else if (textures_.count(addr.withoutBack()) && addr.getBack() == "resolution") {
                         auto res = textures_.at(addr.withoutBack())->getResolution();
                         program->setUniform(uni_name, [&res](GLint& id) {
@@ -116,7 +121,16 @@ namespace vidrevolt {
             }
         }
 
-        void Renderer::render(const Address target, cv::Mat& frame) {
+        void Renderer::render(const Address target, cv::Mat& frame, FrameSource::PixelFormat format) {
+            if (format == FrameSource::NV12) {
+                if (converters_.count(target) <= 0) {
+                    converters_[target] = std::make_unique<YUVConverter>();
+                }
+
+                textures_[target] = converters_.at(target)->convert(frame);
+                return;
+            }
+
             if (textures_.count(target) <= 0) {
                 textures_[target] = std::make_shared<Texture>();
             }
@@ -124,6 +138,24 @@ namespace vidrevolt {
             textures_.at(target)->populate(frame);
         }
 
+        void Renderer::render(const Address target, const FrameSource::Blend& blend, FrameSource::PixelFormat format) {
+            if (blenders_.count(target) <= 0) {
+                blenders_[target] = std::make_unique<FrameBlender>();
+            }
+
+            textures_[target] = blenders_.at(target)->blend(blend, format);
+        }
+
+        void Renderer::placeholder(const Address target, const Resolution& res) {
+            if (textures_.count(target) > 0 || res.width <= 0 || res.height <= 0) {
+                return;
+            }
+
+            cv::Mat black(res.height, res.width, CV_8UC3, cv::Scalar(0, 0, 0));
+            textures_[target] = std::make_shared<Texture>();
+            textures_.at(target)->populate(black);
+        }
+
         std::map<std::string, std::shared_ptr<Module>> Renderer::getModules() {
             return modules_;
         }
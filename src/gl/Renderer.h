@@ -13,6 +13,9 @@
 #include "gl/RenderOut.h"
 #include "gl/Module.h"
 #include "gl/ParamSet.h"
+#include "gl/YUVConverter.h"
+#include "gl/FrameBlender.h"
+#include "FrameSource.h"
 #include "Resolution.h"
 
 // OpenGL
@@ -24,7 +27,14 @@ namespace vidrevolt {
         class Renderer {
             public:
                 void render(const Address target, const std::string& shader_path, ParamSet params);
-                void render(const Address target, cv::Mat& frame);
+                void render(const Address target, cv::Mat& frame,
+                        FrameSource::PixelFormat format = FrameSource::BGR);
+                void render(const Address target, const FrameSource::Blend& blend,
+                        FrameSource::PixelFormat format = FrameSource::BGR);
+
+                // Black stand-in for a source without frames yet, unless it
+                // already has a texture
+                void placeholder(const Address target, const Resolution& res);
 
                 void preloadModule(const std::string& shader_path);
 
@@ -40,6 +50,8 @@ namespace vidrevolt {
                 std::map<Address, std::shared_ptr<Texture>> textures_;
                 std::map<Address, std::shared_ptr<RenderOut>> render_outs_;
                 std::map<std::string, std::shared_ptr<Module>> modules_;
+                std::map<Address, std::unique_ptr<YUVConverter>> converters_;
+                std::map<Address, std::unique_ptr<FrameBlender>> blenders_;
 
                 std::shared_ptr<RenderOut> last_;
                 std::shared_ptr<RenderOut> last_aux_;
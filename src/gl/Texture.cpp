@@ -14,6 +14,11 @@ namespace vidrevolt {
         }
 
         Texture::~Texture() {
+            if (read_fbo_ != 0) {
+                glDeleteFramebuffers(1, &read_fbo_);
+                glDeleteFramebuffers(1, &flip_fbo_);
+            }
+
             glDeleteTextures(1, &glID_);
         }
 
@@ -34,21 +39,53 @@ namespace vidrevolt {
         }
 
         cv::Mat Texture::read() {
-            cv::Mat image;
-            borrowBind([&image, this]() {
-                GLint alignment;
-                GLCall(glGetIntegerv(GL_PACK_ALIGNMENT, &alignment));
+            Resolution res = getResolution();
+            int width = res.width;
+            int height = res.height;
+
+            GLint prev_read = 0;
+            GLint prev_draw = 0;
+            GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prev_read));
+            GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_draw));
+
+            if (read_fbo_ == 0) {
+                GLCall(glGenFramebuffers(1, &read_fbo_));
+                GLCall(glGenFramebuffers(1, &flip_fbo_));
+                flip_tex_ = std::make_unique<Texture>();
+            }
 
-                Resolution res = getResolution();
-                int width = res.width;
-                int height = res.height;
+            Resolution flip_res = flip_tex_->getResolution();
+            if (flip_res.width != width || flip_res.height != height) {
+                flip_tex_->populate(GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
 
-                // Load the actual image daata
-                char* data = new char[static_cast<size_t>(width) * static_cast<size_t>(height) * 3];
-                GLCall(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, data));
+            // Flip with a blit on the GPU rather than a pass over the image
+            GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo_));
+            GLCall(glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, glID_, 0));
+            GLCall(glReadBuffer(GL_COLOR_ATTACHMENT0));
 
-                image = cv::Mat(height, width, CV_8UC3, data);
-            });
+            GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, flip_fbo_));
+            GLCall(glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, flip_tex_->getID(), 0));
+            GLCall(glDrawBuffer(GL_COLOR_ATTACHMENT0));
+
+            int top = flipped_ ? 0 : height;
+            GLCall(glBlitFramebuffer(0, 0, width, height, 0, top, width, height - top,
+                        GL_COLOR_BUFFER_BIT, GL_NEAREST));
+
+            // And let the readback put the channels in OpenCV's order
+            cv::Mat image(height, width, CV_8UC3);
+
+            GLint alignment = 0;
+            GLCall(glGetIntegerv(GL_PACK_ALIGNMENT, &alignment));
+            GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+
+            GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, flip_fbo_));
+            GLCall(glReadBuffer(GL_COLOR_ATTACHMENT0));
+            GLCall(glReadPixels(0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, image.data));
+
+            GLCall(glPixelStorei(GL_PACK_ALIGNMENT, alignment));
+            GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(prev_read)));
+            GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(prev_draw)));
 
             return image;
         }
@@ -56,7 +93,27 @@ namespace vidrevolt {
         void Texture::populate(cv::Mat& frame) {
             cv::Size size = frame.size();
 
+            // Swap red and blue when sampling instead of on the CPU
+            if (!swizzled_) {
+                borrowBind([]() {
+                    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_BLUE));
+                    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED));
+                });
+                swizzled_ = true;
+            }
+            flipped_ = true;
+
+            // Rows of 3 byte pixels are rarely 4 byte aligned, and views
+            // into a larger image are padded, so go by the row stride.
+            GLint alignment = 0;
+            GLCall(glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment));
+            GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(frame.step[0] / frame.elemSize())));
+
             this->populate(GL_RGB, size.width, size.height, GL_RGB, GL_UNSIGNED_BYTE, frame.data);
+
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+            GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, alignment));
         }
 
         void Texture::populate(GLint internal_format, GLsizei width, GLsizei height,
@@ -65,6 +122,10 @@ namespace vidrevolt {
             borrowBind([internal_format, width, height, format, type, data]() {
                 GLCall(glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, data));
             });
+
+            // Sources can change size mid-stream (e.g. switching to a proxy)
+            res_.width = width;
+            res_.height = height;
         }
 
         void Texture::borrowBind(std::function<void()> f) {
@@ -97,5 +158,13 @@ namespace vidrevolt {
         GLuint Texture::getID() const {
             return glID_;
         }
+
+        bool Texture::isFlipped() const {
+            return flipped_;
+        }
+
+        void Texture::setFlipped(bool flipped) {
+            flipped_ = flipped;
+        }
     }
 }
@@ -3,6 +3,7 @@
 
 // STL
 #include <functional>
+#include <memory>
 
 // OpenCV
 #include <opencv2/opencv.hpp>
@@ -18,11 +19,13 @@ namespace vidrevolt {
                 Texture();
                 ~Texture();
 
+                // BGR with the top row first, ready for OpenCV
                 cv::Mat read();
                 void bind(unsigned int slot = 0);
                 void unbind();
                 void populate(GLint internal_format, GLsizei width, GLsizei height,
                         GLenum format, GLenum type, const GLvoid * data);
+                // Takes frames as OpenCV has them (see FrameSource::BGR)
                 void populate(cv::Mat& frame);
                 void borrowBind(std::function<void()> f);
                 void setScaleFilter(GLint min_param, GLint mag_param);
@@ -30,9 +33,20 @@ namespace vidrevolt {
 
                 GLuint getID() const;
 
+                // Whether the top row comes first, samplers have to flip
+                bool isFlipped() const;
+                void setFlipped(bool flipped);
+
             private:
                 unsigned int glID_ = 0;
                 Resolution res_;
+                bool flipped_ = false;
+                bool swizzled_ = false;
+
+                // For flipping on read()
+                GLuint read_fbo_ = 0;
+                GLuint flip_fbo_ = 0;
+                std::unique_ptr<Texture> flip_tex_;
         };
     }
 }
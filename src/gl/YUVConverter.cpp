@@ -0,0 +1,122 @@
+#include "gl/YUVConverter.h"
+
+namespace vidrevolt {
+    namespace gl {
+        YUVConverter::YUVConverter() :
+            program_(std::make_shared<ShaderProgram>()),
+            y_(std::make_shared<Texture>()),
+            uv_(std::make_shared<Texture>()) {
+
+            constexpr auto vert = R"V(
+                #version 410
+
+                layout (location = 0) in vec3 aPos;
+                out vec2 tc;
+
+                void main() {
+                    gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+
+                    // Frames have their top row first, flip while we're here
+                    tc = aPos.xy * .5 + .5;
+                    tc.y = 1. - tc.y;
+                }
+            )V";
+
+            // Limited range, BT.709 for HD and BT.601 below it, the same
+            // guess players make for untagged video.
+            constexpr auto frag = R"V(
+                #version 410
+
+                in vec2 tc;
+                out vec4 fragColor;
+
+                uniform sampler2D luma;
+                uniform sampler2D chroma;
+                uniform bool bt709;
+
+                void main() {
+                    float y = (texture(luma, tc).r - 16. / 255.) * (255. / 219.);
+                    vec2 uv = (texture(chroma, tc).rg - .5) * (255. / 224.);
+
+                    vec3 rgb;
+                    if (bt709) {
+                        rgb = vec3(
+                            y + 1.5748 * uv.y,
+                            y - .1873 * uv.x - .4681 * uv.y,
+                            y + 1.8556 * uv.x);
+                    } else {
+                        rgb = vec3(
+                            y + 1.402 * uv.y,
+                            y - .3441 * uv.x - .7141 * uv.y,
+                            y + 1.772 * uv.x);
+                    }
+
+                    fragColor = vec4(clamp(rgb, 0., 1.), 1.);
+                }
+            )V";
+
+            program_->loadShaderStr(GL_VERTEX_SHADER, vert, "internal-yuv-vert.glsl");
+            program_->loadShaderStr(GL_FRAGMENT_SHADER, frag, "internal-yuv-frag.glsl");
+            program_->compile();
+        }
+
+        std::shared_ptr<Texture> YUVConverter::convert(const cv::Mat& frame) {
+            int width = frame.cols;
+            int height = frame.rows * 2 / 3;
+
+            // The output follows the frame, which can change size mid-stream
+            if (out_ == nullptr || res_.width != width || res_.height != height) {
+                res_.width = width;
+                res_.height = height;
+                out_ = std::make_shared<RenderOut>(res_, GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1);
+                out_->load();
+            }
+
+            // Rows of odd widths aren't 4 byte aligned, and planes may be
+            // padded, so go by the row stride as Texture::populate() does.
+            // It's in pixels, one byte each for Y and two for UV.
+            size_t stride = frame.step[0] / frame.elemSize();
+            GLint alignment = 0;
+            GLCall(glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment));
+            GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride)));
+            y_->populate(GL_R8, width, height, GL_RED, GL_UNSIGNED_BYTE, frame.data);
+
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride / 2)));
+            uv_->populate(GL_RG8, width / 2, height / 2, GL_RG, GL_UNSIGNED_BYTE,
+                    frame.data + static_cast<size_t>(height) * frame.step[0]);
+
+            GLCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+            GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, alignment));
+
+            GLint viewport[4];
+            GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+
+            out_->bind(program_);
+
+            program_->setUniform("luma", [this](GLint& id) {
+                y_->bind(0);
+                glUniform1i(id, 0);
+            });
+
+            program_->setUniform("chroma", [this](GLint& id) {
+                uv_->bind(1);
+                glUniform1i(id, 1);
+            });
+
+            bool bt709 = height >= 720;
+            program_->setUniform("bt709", [bt709](GLint& id) {
+                glUniform1i(id, bt709 ? 1 : 0);
+            });
+
+            GLCall(glViewport(0, 0, width, height));
+            GLCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0));
+
+            out_->unbind(program_);
+            GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+
+            return out_->getSrcTex();
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef VIDREVOLT_GL_YUVCONVERTER_H_
+#define VIDREVOLT_GL_YUVCONVERTER_H_
+
+// STL
+#include <memory>
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// Ours
+#include "gl/RenderOut.h"
+#include "gl/ShaderProgram.h"
+#include "gl/Texture.h"
+#include "Resolution.h"
+
+namespace vidrevolt {
+    namespace gl {
+        // Turns NV12 frames (see FrameSource::NV12) into RGB textures. The
+        // planes are uploaded as a luma and a half resolution chroma
+        // texture and converted in a pass of their own at the frame's
+        // resolution.
+        class YUVConverter {
+            public:
+                YUVConverter();
+
+                // The RGB result, valid until the next call
+                std::shared_ptr<Texture> convert(const cv::Mat& frame);
+
+            private:
+                std::shared_ptr<ShaderProgram> program_;
+                std::shared_ptr<Texture> y_;
+                std::shared_ptr<Texture> uv_;
+                std::shared_ptr<RenderOut> out_;
+                Resolution res_;
+        };
+    }
+}
+
+#endif
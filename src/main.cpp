@@ -39,6 +39,11 @@
 #include "Value.h"
 #include "Controller.h"
 #include "VideoWriter.h"
+#include "FramePool.h"
+#include "FrameBudget.h"
+#include "FrameCache.h"
+#include "ProxyTranscoder.h"
+#include "SharedFrames.h"
 
 #ifndef DOUBLE_BUF
 #define DOUBLE_BUF true
@@ -85,6 +90,11 @@ int main(int argc, const char** argv) {
     TCLAP::ValueArg<std::string> img_out_arg("", "image-out", "output image path", false, "", "string", cmd);
     TCLAP::ValueArg<std::string> vid_out_arg("o", "vid-out", "output to video path", false, "", "string", cmd);
     TCLAP::ValueArg<int> height_arg("", "height", "window height (width will be calculated automatically)", false, 720, "int", cmd);
+    TCLAP::ValueArg<int> frame_cache_arg("", "frame-cache", "memory in MB for LZ4 compressed decoded frames (0 to disable)", false, 0, "int", cmd);
+    TCLAP::SwitchArg proxies_arg("", "proxies", "transcode long-GOP videos to intra-only proxies in the background", cmd);
+    TCLAP::ValueArg<int> proxy_height_arg("", "proxy-height", "height of proxies (0 to keep the source's)", false, 0, "int", cmd);
+    TCLAP::SwitchArg lazy_arg("", "lazy", "open videos when first rendered (or prefetched) rather than when declared", cmd);
+    TCLAP::ValueArg<int> frame_budget_arg("", "frame-budget", "memory budget in MB for buffered video frames (0 for unlimited)", false, 0, "int", cmd);
     TCLAP::SwitchArg debug_timer_arg("", "debug-timer", "debug time between frames", cmd);
     TCLAP::SwitchArg debug_opengl("", "debug-opengl", "print out OpenGL debugging info", cmd);
     TCLAP::SwitchArg full_arg("", "full", "full screen", cmd);
@@ -190,6 +200,13 @@ int main(int argc, const char** argv) {
     auto frontend = std::make_shared<vidrevolt::LuaFrontend>(pipeline_arg.getValue(), pipeline);
 
     try {
+        // Set before loading so they apply while the script opens videos;
+        // the script may still override them with setFrameBudget(),
+        // setFrameCache(), setProxies() and setLazyOpen().
+        pipeline->setFrameBudget(frame_budget_arg.getValue());
+        pipeline->setFrameCache(frame_cache_arg.getValue());
+        pipeline->setProxies(proxies_arg.getValue(), proxy_height_arg.getValue());
+        pipeline->setLazyOpen(lazy_arg.getValue());
         frontend->load();
     } catch (const std::runtime_error& error) {
         std::cerr << "Error: " << error.what() << std::endl;
@@ -257,8 +274,6 @@ int main(int argc, const char** argv) {
 
         // Explicitly image by copy; if we pass by reference the internal refcount wont increment
         shot_futures_.push_back(std::async([dest, image]() {
-            cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
-            flip(image, image, 0);
             cv::imwrite(dest, image);
             std::cerr << "Screenshot saved at " << dest << std::endl;
         }));
@@ -272,6 +287,72 @@ int main(int argc, const char** argv) {
         pipeline->reconnectControllers();
     });
 
+    // Dump decode statistics
+    keyboard->connect("v", [pipeline](vidrevolt::Value v) {
+        if (v.getBool()) {
+            return;
+        }
+
+        std::cerr << vidrevolt::FramePool::getInstance().str();
+        std::cerr << vidrevolt::FrameCache::getInstance().str();
+        std::cerr << vidrevolt::ProxyTranscoder::getInstance().str();
+        std::cerr << vidrevolt::SharedFrames::str();
+
+        auto& budget = vidrevolt::FrameBudget::getInstance();
+        std::cerr << "frame budget: used=" << budget.getUsed() / (1024 * 1024) << "MB limit=" <<
+            budget.getLimit() / (1024 * 1024) << "MB" << std::endl;
+
+        for (const auto& kv : pipeline->getVideoStats()) {
+            const auto& stats = kv.second;
+            std::cerr << kv.first << ": " << (stats.in_focus ? "in focus" : "out of focus") <<
+                " refills=" << stats.refills <<
+                " depth=" << stats.buffer_depth <<
+                " underruns=" << stats.underruns <<
+                " refill (last/avg/max)=" << stats.refill_last_ms << "/" << stats.refill_avg_ms << "/" <<
+                stats.refill_max_ms << "ms" <<
+                " decode=" << stats.decode_fps << "fps" <<
+                " filled=" << stats.buffered_frames << " (" << stats.frames_ahead << " ahead)" <<
+                (stats.keyframes_indexed ? " indexed" : "") <<
+                " decoded=" << stats.frames_decoded <<
+                " reused=" << stats.frames_reused <<
+                " cached=" << stats.frames_cached <<
+                " shared=" << stats.frames_shared << " (" << stats.shared_users << " users)" <<
+                (stats.started ? "" : " not opened") <<
+                (stats.decoder_open ? "" : " no decoder") <<
+                " skipped=" << stats.frames_skipped <<
+                (stats.proxy_active ? " proxy" : "") <<
+                " frame=" << stats.frame_bytes / 1024 << "KB" <<
+                (stats.pixel_format == vidrevolt::FrameSource::NV12 ?
+                    " (nv12, rgb " + std::to_string(stats.rgb_frame_bytes / 1024) + "KB)" : "") <<
+                " stride=" << stats.stride <<
+                " jitter (last/avg/max)=" << stats.playback.jitter_last_ms << "/" <<
+                stats.playback.jitter_avg_ms << "/" << stats.playback.jitter_max_ms << "ms" <<
+                " dropped=" << stats.playback.dropped <<
+                " seeks=" << stats.seeks << " (" << stats.seeks_buffered << " buffered)" <<
+                " seek latency (last/avg/max)=" << stats.seek_latency_last_ms << "/" <<
+                stats.seek_latency_avg_ms << "/" << stats.seek_latency_max_ms << "ms" <<
+                " cues=" << stats.cues_shown << " (" << stats.cues_pinned << " pinned, " <<
+                stats.cue_bytes / (1024 * 1024) << "MB)" <<
+                " cue latency (last/avg/max)=" << stats.cue_latency_last_ms << "/" <<
+                stats.cue_latency_avg_ms << "/" << stats.cue_latency_max_ms << "ms" <<
+                " preload=" << static_cast<int>(stats.preload_progress * 100) << "% (" <<
+                stats.preload_bytes / (1024 * 1024) << "MB)" <<
+                " buffered=" << stats.buffered_bytes / (1024 * 1024) << "MB" <<
+                " evictions=" << stats.evictions <<
+                " queue wait (last/avg/max)=" << stats.queue_wait.last_ms << "/" <<
+                stats.queue_wait.avg_ms << "/" << stats.queue_wait.max_ms << "ms" << std::endl;
+        }
+
+        for (const auto& kv : pipeline->getPlaylistStats()) {
+            const auto& stats = kv.second;
+            std::cerr << kv.first << ": clip=" << stats.clip <<
+                " cuts=" << stats.cuts <<
+                " stalls=" << stats.stalls <<
+                " preroll lead (last/min/avg)=" << stats.preroll_last_ms << "/" <<
+                stats.preroll_min_ms << "/" << stats.preroll_avg_ms << "ms" << std::endl;
+        }
+    });
+
     // Exit key
     keyboard->connect("escape", [&primary_window](vidrevolt::Value v) {
         // On key release
@@ -0,0 +1,67 @@
+// Converts any video the decode backends can read into a .vrclip (see
+// src/decode/ClipFormat.h) that Video can then seek anywhere in for free.
+//
+// Usage: vidrevolt-clip -i <video path> [-o <clip path>] [--lz4] [--backend opencv|libav]
+
+// STL
+#include <iostream>
+#include <string>
+
+// TCLAP
+#include <tclap/ArgException.h>
+#include <tclap/CmdLine.h>
+#include <tclap/SwitchArg.h>
+#include <tclap/ValueArg.h>
+
+// Ours
+#include "decode/Backend.h"
+#include "decode/ClipWriter.h"
+
+int main(int argc, const char** argv) {
+    TCLAP::CmdLine cmd("Convert a video to a VidRevolt clip");
+
+    TCLAP::ValueArg<std::string> in_arg("i", "input", "path to source video", true, "", "string", cmd);
+    TCLAP::ValueArg<std::string> out_arg("o", "output", "path to write the clip to (defaults to the input path plus "
+            VIDREVOLT_CLIP_EXTENSION ")", false, "", "string", cmd);
+    TCLAP::ValueArg<std::string> backend_arg("", "backend", "decode backend to read the source with (opencv or libav)",
+            false, "libav", "string", cmd);
+    TCLAP::SwitchArg lz4_arg("", "lz4", "LZ4 compress frames (smaller, costs a decompression per frame)", cmd);
+
+    try {
+        cmd.parse(argc, argv);
+    } catch (TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        return 1;
+    }
+
+    std::string in_path = in_arg.getValue();
+    std::string out_path = out_arg.getValue().empty() ? in_path + VIDREVOLT_CLIP_EXTENSION : out_arg.getValue();
+
+    try {
+        auto backend = vidrevolt::decode::Backend::create(
+                vidrevolt::decode::Backend::typeFromString(backend_arg.getValue()), in_path);
+        auto md = backend->probe();
+
+        vidrevolt::decode::ClipWriter writer(out_path, md.fps,
+                lz4_arg.getValue() ? vidrevolt::decode::ClipLZ4 : vidrevolt::decode::ClipRaw);
+
+        vidrevolt::decode::Frame frame;
+        int frames = 0;
+        while (backend->read(frame)) {
+            writer.write(frame);
+            frames++;
+
+            if (frames % 100 == 0) {
+                std::cerr << "\r" << frames << "/" << md.frame_count << " frames" << std::flush;
+            }
+        }
+
+        writer.close();
+        std::cerr << "\r" << frames << " frames written to " << out_path << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}